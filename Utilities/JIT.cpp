@@ -7,10 +7,15 @@
 #include "mutex.h"
 #include "util/vm.hpp"
 #include "util/asm.hpp"
+#include "Emu/system_config.h"
 #include <charconv>
 #include <zlib.h>
 
 #ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <time.h>
 #define CAN_OVERCOMMIT
 #endif
 
@@ -191,6 +196,147 @@ void jit_runtime::finalize() noexcept
 	std::memcpy(alloc(s_data_init.size(), 1, false), s_data_init.data(), s_data_init.size());
 }
 
+#ifdef __linux__
+
+// Jitdump format, see tools/perf/Documentation/jitdump-specification.txt in the Linux sources
+struct jitdump_header
+{
+	u32 magic = 0x4A695444;
+	u32 version = 1;
+	u32 total_size = sizeof(jitdump_header);
+	u32 elf_mach = 62; // EM_X86_64
+	u32 pad1 = 0;
+	u32 pid;
+	u64 timestamp;
+	u64 flags = 0;
+};
+
+struct jitdump_code_load
+{
+	u32 id = 0; // JIT_CODE_LOAD
+	u32 total_size;
+	u64 timestamp;
+	u32 pid;
+	u32 tid;
+	u64 vma;
+	u64 code_addr;
+	u64 code_size;
+	u64 code_index;
+	// Followed by the null-terminated name and the code
+};
+
+static u64 jitdump_timestamp()
+{
+	// Must match the clock of perf record (-k mono)
+	timespec ts{};
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1'000'000'000ull + ts.tv_nsec;
+}
+
+#endif
+
+void jit_announce(uptr func, usz size, std::string_view name)
+{
+	const jit_profiler_output mode = g_cfg.core.jit_profiler;
+
+	if (mode == jit_profiler_output::disabled || !size)
+	{
+		return;
+	}
+
+#ifdef __linux__
+	static shared_mutex s_mutex;
+
+	// Files are opened on first use and kept for the lifetime of the process, like the pid in their names
+	static fs::file s_map, s_dump;
+	static bool s_map_failed = false, s_dump_failed = false;
+	static u64 s_code_index = 0;
+
+	std::lock_guard lock(s_mutex);
+
+	if (mode == jit_profiler_output::perf_map)
+	{
+		if (!s_map && !s_map_failed)
+		{
+			const std::string path = fmt::format("/tmp/perf-%d.map", getpid());
+
+			if (s_map.open(path, fs::rewrite + fs::append))
+			{
+				jit_log.notice("Writing JIT symbols to %s", path);
+			}
+			else
+			{
+				jit_log.error("Failed to create %s (%s)", path, fs::g_tls_error);
+				s_map_failed = true;
+			}
+		}
+
+		if (s_map)
+		{
+			const std::string line = fmt::format("%x %x %s\n", func, size, name);
+			s_map.write(line.data(), line.size());
+		}
+
+		return;
+	}
+
+	if (!s_dump && !s_dump_failed)
+	{
+		const std::string path = fmt::format("/tmp/jit-%d.dump", getpid());
+
+		if (s_dump.open(path, fs::rewrite))
+		{
+			jitdump_header header{};
+			header.pid = getpid();
+			header.timestamp = jitdump_timestamp();
+			s_dump.write(&header, sizeof(header));
+
+			// perf record finds the file through an executable mapping of it
+			if (::mmap(nullptr, sysconf(_SC_PAGESIZE), PROT_READ | PROT_EXEC, MAP_PRIVATE, s_dump.get_handle(), 0) == MAP_FAILED)
+			{
+				jit_log.error("Failed to map %s, perf will not find it", path);
+			}
+
+			jit_log.notice("Writing JIT code to %s", path);
+		}
+		else
+		{
+			jit_log.error("Failed to create %s (%s)", path, fs::g_tls_error);
+			s_dump_failed = true;
+		}
+	}
+
+	if (s_dump)
+	{
+		jitdump_code_load record{};
+		record.total_size = ::narrow<u32>(sizeof(record) + name.size() + 1 + size);
+		record.timestamp = jitdump_timestamp();
+		record.pid = getpid();
+		record.tid = static_cast<u32>(::syscall(SYS_gettid));
+		record.vma = func;
+		record.code_addr = func;
+		record.code_size = size;
+		record.code_index = s_code_index++;
+
+		std::string data(reinterpret_cast<const char*>(&record), sizeof(record));
+		data += name;
+		data += '\0';
+		data.append(reinterpret_cast<const char*>(func), size);
+		s_dump.write(data.data(), data.size());
+	}
+#else
+	static atomic_t<bool> s_warned = false;
+
+	if (!s_warned.exchange(true))
+	{
+		jit_log.warning("JIT symbols for host profilers are only supported on Linux");
+	}
+
+	static_cast<void>(func);
+	static_cast<void>(name);
+#endif
+}
+
 asmjit::Runtime& asmjit::get_global_runtime()
 {
 	// 16 MiB for internal needs
@@ -293,6 +439,8 @@ asmjit::Runtime& asmjit::get_global_runtime()
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
 #include "llvm/ExecutionEngine/RTDyldMemoryManager.h"
 #include "llvm/ExecutionEngine/ObjectCache.h"
+#include "llvm/ExecutionEngine/JITEventListener.h"
+#include "llvm/Object/SymbolSize.h"
 #ifdef _MSC_VER
 #pragma warning(pop)
 #else
@@ -667,6 +815,56 @@ public:
 	}
 };
 
+// Reports functions of the loaded objects to jit_announce
+class jit_announcer final : public llvm::JITEventListener
+{
+public:
+	std::string prefix;
+
+	// Name of the module or object file being loaded
+	std::string object_name;
+
+	void notifyObjectLoaded(ObjectKey, const llvm::object::ObjectFile& obj, const llvm::RuntimeDyld::LoadedObjectInfo& info) override
+	{
+		if (g_cfg.core.jit_profiler == jit_profiler_output::disabled)
+		{
+			return;
+		}
+
+		// The debug object contains the final addresses of the sections
+		const auto debug_obj = info.getObjectForDebug(obj);
+
+		if (!debug_obj.getBinary())
+		{
+			jit_log.error("Failed to announce functions of %s", object_name);
+			return;
+		}
+
+		for (const auto& [sym, size] : llvm::object::computeSymbolSizes(*debug_obj.getBinary()))
+		{
+			auto type = sym.getType();
+
+			if (!type || *type != llvm::object::SymbolRef::ST_Function)
+			{
+				llvm::consumeError(type.takeError());
+				continue;
+			}
+
+			auto name = sym.getName();
+			auto addr = sym.getAddress();
+
+			if (!name || !addr)
+			{
+				llvm::consumeError(name.takeError());
+				llvm::consumeError(addr.takeError());
+				continue;
+			}
+
+			jit_announce(*addr, size, fmt::format("%s%s [%s]", prefix, std::string_view(name->data(), name->size()), object_name));
+		}
+	}
+};
+
 std::string jit_compiler::cpu(const std::string& _cpu)
 {
 	std::string m_cpu = _cpu;
@@ -746,11 +944,12 @@ jit_compiler::jit_compiler(const std::unordered_map<std::string, u64>& _link, co
 		}
 
 		// Auxiliary JIT (does not use custom memory manager, only writes the objects)
+		// Flag 0x4 trades code quality for compilation speed
 		m_engine.reset(llvm::EngineBuilder(std::move(null_mod))
 			.setErrorStr(&result)
 			.setEngineKind(llvm::EngineKind::JIT)
 			.setMCJITMemoryManager(std::move(mem))
-			.setOptLevel(llvm::CodeGenOpt::Aggressive)
+			.setOptLevel(flags & 0x4 ? llvm::CodeGenOpt::Less : llvm::CodeGenOpt::Aggressive)
 			.setCodeModel(flags & 0x2 ? llvm::CodeModel::Large : llvm::CodeModel::Small)
 			.setMCPU(m_cpu)
 			.create());
@@ -777,6 +976,13 @@ jit_compiler::jit_compiler(const std::unordered_map<std::string, u64>& _link, co
 	{
 		fmt::throw_exception("LLVM: Failed to create ExecutionEngine: %s", result);
 	}
+
+	// Auxiliary JIT with MemoryManager1 only writes object files, its code is never executed
+	if (!_link.empty() || !(flags & 0x1))
+	{
+		m_announcer = std::make_unique<jit_announcer>();
+		m_engine->RegisterJITEventListener(m_announcer.get());
+	}
 }
 
 jit_compiler::~jit_compiler()
@@ -785,6 +991,11 @@ jit_compiler::~jit_compiler()
 
 void jit_compiler::add(std::unique_ptr<llvm::Module> _module, const std::string& path)
 {
+	if (m_announcer)
+	{
+		m_announcer->object_name = _module->getName().str();
+	}
+
 	ObjectCache cache{path};
 	m_engine->setObjectCache(&cache);
 
@@ -802,6 +1013,11 @@ void jit_compiler::add(std::unique_ptr<llvm::Module> _module, const std::string&
 
 void jit_compiler::add(std::unique_ptr<llvm::Module> _module)
 {
+	if (m_announcer)
+	{
+		m_announcer->object_name = _module->getName().str();
+	}
+
 	const auto ptr = _module.get();
 	m_engine->addModule(std::move(_module));
 	m_engine->generateCodeForModule(ptr);
@@ -815,6 +1031,11 @@ void jit_compiler::add(std::unique_ptr<llvm::Module> _module)
 
 void jit_compiler::add(const std::string& path)
 {
+	if (m_announcer)
+	{
+		m_announcer->object_name = path.substr(path.find_last_of('/') + 1);
+	}
+
 	auto cache = ObjectCache::load(path);
 
 	if (auto object_file = llvm::object::ObjectFile::createObjectFile(*cache))
@@ -855,4 +1076,12 @@ u64 jit_compiler::get(const std::string& name)
 	return m_engine->getGlobalValueAddress(name);
 }
 
+void jit_compiler::set_profiler_prefix(std::string prefix)
+{
+	if (m_announcer)
+	{
+		m_announcer->prefix = std::move(prefix);
+	}
+}
+
 #endif
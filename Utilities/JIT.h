@@ -27,6 +27,7 @@
 
 #include <array>
 #include <functional>
+#include <string_view>
 
 enum class jit_class
 {
@@ -58,6 +59,14 @@ struct jit_runtime final : asmjit::HostRuntime
 	static void finalize() noexcept;
 };
 
+// Register generated code with host profilers (Linux perf), does nothing unless enabled in the config
+void jit_announce(uptr func, usz size, std::string_view name);
+
+inline void jit_announce(const void* func, usz size, std::string_view name)
+{
+	jit_announce(reinterpret_cast<uptr>(func), size, name);
+}
+
 namespace asmjit
 {
 	// Should only be used to build global functions
@@ -208,6 +217,9 @@ class jit_compiler final
 	// Local LLVM context
 	llvm::LLVMContext m_context{};
 
+	// Host profiler support (must outlive the engine)
+	std::unique_ptr<class jit_announcer> m_announcer{};
+
 	// Execution instance
 	std::unique_ptr<llvm::ExecutionEngine> m_engine{};
 
@@ -247,6 +259,9 @@ public:
 	// Get compiled function address
 	u64 get(const std::string& name);
 
+	// Set prefix of the function names reported to host profilers
+	void set_profiler_prefix(std::string prefix);
+
 	// Get CPU info
 	static std::string cpu(const std::string& _cpu);
 };
@@ -4,10 +4,15 @@
 #include "PPUOpcodes.h"
 #include "PPUModule.h"
 #include "Emu/system_config.h"
+#include "Emu/system_utils.hpp"
+#include "Crypto/sha1.h"
+#include "Utilities/File.h"
+#include "Utilities/Thread.h"
 
 #include <unordered_set>
 #include "util/yaml.hpp"
 #include "util/asm.hpp"
+#include "util/serialization.hpp"
 
 LOG_CHANNEL(ppu_validator);
 
@@ -529,8 +534,143 @@ namespace ppu_patterns
 	};
 }
 
+// Increment when the analysis results change
+constexpr u32 ppu_analysis_version = 1;
+
+// Get analysis cache file for the module, its name depends on the module code as loaded (after relocations and patches)
+static std::string ppu_get_analysis_path(const ppu_module& _module, u32 lib_toc, u32 entry, u32 sec_end, const std::basic_string<u32>& applied)
+{
+	sha1_context ctx;
+	u8 output[20];
+	sha1_starts(&ctx);
+
+	const auto update = [&](const auto& value)
+	{
+		sha1_update(&ctx, reinterpret_cast<const u8*>(&value), sizeof(value));
+	};
+
+	update(ppu_analysis_version);
+	update(lib_toc);
+	update(entry);
+	update(sec_end);
+
+	for (const auto& seg : _module.segs)
+	{
+		update(seg.addr);
+		update(seg.size);
+
+		if (seg.addr)
+		{
+			sha1_update(&ctx, vm::_ptr<const u8>(seg.addr), seg.size);
+		}
+	}
+
+	for (const auto& sec : _module.secs)
+	{
+		update(sec.addr);
+		update(sec.size);
+	}
+
+	sha1_update(&ctx, reinterpret_cast<const u8*>(applied.data()), applied.size() * sizeof(u32));
+	sha1_finish(&ctx, output);
+
+	return fmt::format("%scache/ppu-analysis/%s-%s.dat", fs::get_cache_dir(), fmt::base57(_module.sha1), fmt::base57(output, 16));
+}
+
+static bool ppu_load_analysis(const std::string& path, std::vector<ppu_function>& funcs)
+{
+	fs::file file(path);
+
+	if (!file)
+	{
+		return false;
+	}
+
+	utils::serial ar;
+	ar.set_reading_state(file.to_vector<u8>());
+
+	// Header: version, SHA-1 of the data which follows
+	if (ar.data.size() < 24)
+	{
+		ppu_log.error("PPU analysis cache is damaged: %s", path);
+		return false;
+	}
+
+	u8 output[20];
+	sha1(ar.data.data() + 24, ar.data.size() - 24, output);
+
+	if (ar.operator u32() != ppu_analysis_version || std::memcmp(ar.data.data() + 4, output, sizeof(output)) != 0)
+	{
+		ppu_log.error("PPU analysis cache is damaged: %s", path);
+		return false;
+	}
+
+	ar.pos = 24;
+
+	const usz count = ar;
+	const usz old_size = funcs.size();
+	funcs.resize(old_size + count);
+
+	for (usz i = old_size; i < funcs.size(); i++)
+	{
+		auto& func = funcs[i];
+		u32 attr = 0;
+		ar(func.addr, func.toc, func.size, attr, func.stack_frame, func.trampoline, func.blocks, func.calls, func.callers, func.name);
+
+		for (u32 bit = 0; bit < bs_t<ppu_attr>::bitsize; bit++)
+		{
+			if (attr & (1u << bit))
+			{
+				func.attr += static_cast<ppu_attr>(bit);
+			}
+		}
+	}
+
+	return true;
+}
+
+static void ppu_save_analysis(const std::string& path, const ppu_function* funcs, usz count)
+{
+	if (!fs::create_path(fs::get_parent_dir(path)))
+	{
+		ppu_log.error("Failed to create PPU analysis cache directory for %s (%s)", path, fs::g_tls_error);
+		return;
+	}
+
+	utils::serial ar;
+
+	// Header placeholder
+	ar.data.resize(24);
+	ar(count);
+
+	for (usz i = 0; i < count; i++)
+	{
+		const auto& func = funcs[i];
+		ar(func.addr, func.toc, func.size, static_cast<u32>(func.attr), func.stack_frame, func.trampoline, func.blocks, func.calls, func.callers, func.name);
+	}
+
+	std::memcpy(ar.data.data(), &ppu_analysis_version, sizeof(u32));
+	sha1(ar.data.data() + 24, ar.data.size() - 24, ar.data.data() + 4);
+
+	if (!fs::write_file(path, fs::rewrite, ar.data))
+	{
+		ppu_log.error("Failed to write PPU analysis cache %s (%s)", path, fs::g_tls_error);
+	}
+}
+
 void ppu_module::analyse(u32 lib_toc, u32 entry, const u32 sec_end, const std::basic_string<u32>& applied)
 {
+	// Analysis results of previous runs
+	const std::string cache_path = ppu_get_analysis_path(*this, lib_toc, entry, sec_end, applied);
+
+	if (ppu_load_analysis(cache_path, funcs))
+	{
+		ppu_log.notice("Loaded PPU analysis results: %zu functions (%s)", funcs.size(), cache_path);
+		return;
+	}
+
+	const usz old_size = funcs.size();
+
 	// Assume first segment is executable
 	const u32 start = segs[0].addr;
 
@@ -617,30 +757,70 @@ void ppu_module::analyse(u32 lib_toc, u32 entry, const u32 sec_end, const std::b
 		return it == known_functions.end() ? end : *it;
 	};
 
-	// Find references indiscriminately
-	for (const auto& seg : segs)
+	// Find references indiscriminately (segments are split into chunks scanned in parallel)
 	{
-		if (!seg.addr) continue;
+		struct scan_chunk
+		{
+			u32 addr;
+			u32 size;
+			std::vector<u32> refs;
+		};
 
-		for (vm::cptr<u32> ptr = vm::cast(seg.addr); ptr.addr() < seg.addr + seg.size; ptr++)
+		std::vector<scan_chunk> chunks;
+
+		for (const auto& seg : segs)
 		{
-			const u32 value = *ptr;
+			if (!seg.addr) continue;
 
-			if (value % 4)
+			for (u32 off = 0; off < seg.size; off += 0x100000)
 			{
-				continue;
+				chunks.push_back(scan_chunk{seg.addr + off, std::min<u32>(seg.size - off, 0x100000)});
 			}
+		}
 
-			for (const auto& _seg : segs)
+		const auto scan = [&](scan_chunk& chunk)
+		{
+			for (vm::cptr<u32> ptr = vm::cast(chunk.addr); ptr.addr() < chunk.addr + chunk.size; ptr++)
 			{
-				if (!_seg.addr) continue;
+				const u32 value = *ptr;
 
-				if (value >= start && value < end)
+				if (value % 4 == 0 && value >= start && value < end)
 				{
-					addr_heap.emplace(value);
-					break;
+					chunk.refs.push_back(value);
 				}
 			}
+
+			std::sort(chunk.refs.begin(), chunk.refs.end());
+			chunk.refs.erase(std::unique(chunk.refs.begin(), chunk.refs.end()), chunk.refs.end());
+		};
+
+		const u32 thread_count = std::min<u32>(rpcs3::utils::get_max_threads(), ::size32(chunks));
+
+		if (thread_count > 1)
+		{
+			atomic_t<u32> index = 0;
+
+			named_thread_group threads("PPUA.", thread_count, [&]()
+			{
+				for (u32 i = index++; i < chunks.size(); i = index++)
+				{
+					scan(chunks[i]);
+				}
+			});
+
+			threads.join();
+		}
+		else
+		{
+			for (auto& chunk : chunks)
+			{
+				scan(chunk);
+			}
+		}
+
+		for (const auto& chunk : chunks)
+		{
+			addr_heap.insert(chunk.refs.begin(), chunk.refs.end());
 		}
 	}
 
@@ -1842,6 +2022,8 @@ void ppu_module::analyse(u32 lib_toc, u32 entry, const u32 sec_end, const std::b
 	}
 
 	ppu_log.notice("Block analysis: %zu blocks (%zu enqueued)", funcs.size(), block_queue.size());
+
+	ppu_save_analysis(cache_path, funcs.data() + old_size, funcs.size() - old_size);
 }
 
 // Temporarily
@@ -0,0 +1,150 @@
+#include "stdafx.h"
+#include "PPUBlockCache.h"
+
+#include "PPUThread.h"
+#include "PPUAnalyser.h"
+#include "Emu/Memory/vm.h"
+#include "Utilities/mutex.h"
+
+atomic_t<u64> g_ppu_code_generation{0};
+
+std::array<atomic_t<u32>, 64> g_ppu_code_lines{};
+
+atomic_t<u64> g_ppu_code_lines_begin{0};
+atomic_t<u64> g_ppu_code_lines_end{0};
+
+// Serializes the writers of the line log
+static shared_mutex s_ppu_code_lines_mutex;
+
+// Get interpreter handler at addr, resolving it first if the instruction was not registered
+extern u64 ppu_get_interpreter_handler(u32 addr);
+
+static const ppu_decoder<ppu_itype> s_ppu_itype;
+
+// Instructions which may transfer control elsewhere
+static bool is_block_end(ppu_itype::type type)
+{
+	switch (type)
+	{
+	case ppu_itype::B:
+	case ppu_itype::BC:
+	case ppu_itype::BCLR:
+	case ppu_itype::BCCTR:
+	case ppu_itype::SC:
+	case ppu_itype::TD:
+	case ppu_itype::TDI:
+	case ppu_itype::TW:
+	case ppu_itype::TWI:
+	case ppu_itype::UNK:
+		return true;
+	default:
+		return false;
+	}
+}
+
+ppu_block* ppu_block_cache::build(u32 addr)
+{
+	auto block = std::make_unique<ppu_block>();
+	block->addr = addr;
+	block->generation = m_generation;
+
+	for (u32 pos = addr; block->ops.size() < max_block_size; pos += 4)
+	{
+		// Don't run into unmapped code (the first instruction is always taken, as before)
+		if (pos != addr && pos % 4096 == 0 && !vm::check_addr(pos, vm::page_executable))
+		{
+			break;
+		}
+
+		const ppu_opcode_t op{vm::read32(pos)};
+
+		block->ops.push_back({reinterpret_cast<decltype(ppu_block::entry::func)>(ppu_get_interpreter_handler(pos)), op});
+
+		if (is_block_end(s_ppu_itype.decode(op.opcode)))
+		{
+			break;
+		}
+	}
+
+	block->ops.shrink_to_fit();
+
+	return (m_blocks[addr] = std::move(block)).get();
+}
+
+void ppu_invalidate_line(u32 addr)
+{
+	std::lock_guard lock(s_ppu_code_lines_mutex);
+
+	const u64 pos = g_ppu_code_lines_end;
+
+	// Readers check the begin counter after reading to detect overwritten entries
+	g_ppu_code_lines_begin.release(pos + 1);
+	g_ppu_code_lines[pos % g_ppu_code_lines.size()].release(addr & -128);
+	g_ppu_code_lines_end.release(pos + 1);
+}
+
+bool ppu_block_cache::invalidate_lines()
+{
+	// Discarded blocks are kept alive because links may point to them, don't let them pile up
+	constexpr usz max_retired = 256;
+
+	const u64 end = g_ppu_code_lines_end;
+
+	if (end - m_line_pos > g_ppu_code_lines.size() || (m_depth <= 1 && m_retired.size() > max_retired))
+	{
+		flush();
+		return false;
+	}
+
+	for (u64 pos = m_line_pos; pos < end; pos++)
+	{
+		const u32 line = g_ppu_code_lines[pos % g_ppu_code_lines.size()];
+
+		// Blocks may start up to max_block_size instructions before the line
+		for (u32 addr = line - (max_block_size - 1) * 4; addr != line + 128; addr += 4)
+		{
+			const auto found = m_blocks.find(addr);
+
+			if (found == m_blocks.end() || (addr - line >= 128 && found->second->ops.size() * 4 <= line - addr))
+			{
+				continue;
+			}
+
+			found->second->generation = umax;
+			m_retired.emplace_back(std::move(found->second));
+			m_blocks.erase(found);
+		}
+	}
+
+	if (g_ppu_code_lines_begin - m_line_pos > g_ppu_code_lines.size())
+	{
+		// Entries were overwritten while they were read
+		flush();
+		return false;
+	}
+
+	m_line_pos = end;
+	return true;
+}
+
+void ppu_block_cache::flush()
+{
+	m_line_pos = g_ppu_code_lines_end;
+
+	if (m_depth > 1)
+	{
+		// Keep the blocks alive until the outermost loop runs again
+		for (auto& [addr, block] : m_blocks)
+		{
+			block->generation = umax;
+			m_retired.emplace_back(std::move(block));
+		}
+	}
+	else
+	{
+		m_retired.clear();
+	}
+
+	m_blocks.clear();
+	m_generation = g_ppu_code_generation;
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "PPUOpcodes.h"
+
+#include "util/types.hpp"
+#include "util/atomic.hpp"
+
+#include <array>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class ppu_thread;
+
+// Incremented whenever PPU code or its interpreter handlers change
+extern atomic_t<u64> g_ppu_code_generation;
+
+// Discard the predecoded blocks of all PPU threads
+inline void ppu_invalidate_blocks()
+{
+	g_ppu_code_generation++;
+}
+
+// Log of the code lines invalidated by ICBI, threads discard only the blocks which overlap them
+extern std::array<atomic_t<u32>, 64> g_ppu_code_lines;
+
+// Number of lines being recorded and number of lines recorded in the log
+extern atomic_t<u64> g_ppu_code_lines_begin;
+extern atomic_t<u64> g_ppu_code_lines_end;
+
+// Discard the predecoded blocks of all PPU threads which overlap the 128-byte line at addr
+void ppu_invalidate_line(u32 addr);
+
+// Straight-line sequence of PPU instructions with their interpreter handlers resolved.
+// It ends after the first branch, system call or trap instruction.
+struct ppu_block
+{
+	struct entry
+	{
+		bool(*func)(ppu_thread&, ppu_opcode_t);
+		ppu_opcode_t op;
+	};
+
+	u32 addr = 0;
+	std::vector<entry> ops;
+
+	// Code generation the block was built for (umax once the block is discarded)
+	u64 generation = umax;
+
+	// Recent successors of the block (target address, block)
+	std::array<std::pair<u32, ppu_block*>, 2> links{};
+	u32 link_pos = 0;
+};
+
+// Per-thread cache of the predecoded blocks used by the PPU interpreter
+class ppu_block_cache
+{
+	std::unordered_map<u32, std::unique_ptr<ppu_block>> m_blocks;
+
+	// Invalidated blocks which may still be executed by an outer interpreter loop
+	std::vector<std::unique_ptr<ppu_block>> m_retired;
+
+	u64 m_generation = umax;
+	u64 m_line_pos = 0;
+	u32 m_depth = 0;
+
+	ppu_block* build(u32 addr);
+	void flush();
+
+	// Discard the blocks overlapping the lines logged since the last call, returns false if everything was discarded
+	bool invalidate_lines();
+
+public:
+	// Maximal number of instructions in a block
+	static constexpr u32 max_block_size = 64;
+
+	// Must be held by the interpreter loop while it executes blocks (the loop can be nested through HLE callbacks)
+	class scope
+	{
+		ppu_block_cache& m_cache;
+
+	public:
+		scope(ppu_block_cache& cache) noexcept
+			: m_cache(cache)
+		{
+			m_cache.m_depth++;
+		}
+
+		scope(const scope&) = delete;
+
+		scope& operator=(const scope&) = delete;
+
+		~scope()
+		{
+			m_cache.m_depth--;
+		}
+	};
+
+	// Get the block at addr, following the links of the previously executed block if possible
+	ppu_block* get(ppu_block* prev, u32 addr)
+	{
+		if (m_generation != g_ppu_code_generation) [[unlikely]]
+		{
+			flush();
+			prev = nullptr;
+		}
+		else if (m_line_pos != g_ppu_code_lines_end) [[unlikely]]
+		{
+			if (!invalidate_lines())
+			{
+				prev = nullptr;
+			}
+		}
+
+		// A nested interpreter loop may have discarded the previous block
+		if (prev && prev->generation != m_generation)
+		{
+			prev = nullptr;
+		}
+
+		if (prev)
+		{
+			for (const auto& [target, block] : prev->links)
+			{
+				if (target == addr && block && block->generation == m_generation)
+				{
+					return block;
+				}
+			}
+		}
+
+		ppu_block* block;
+
+		if (const auto found = m_blocks.find(addr); found != m_blocks.end()) [[likely]]
+		{
+			block = found->second.get();
+		}
+		else
+		{
+			block = build(addr);
+		}
+
+		if (prev)
+		{
+			prev->links[prev->link_pos++ % prev->links.size()] = {addr, block};
+		}
+
+		return block;
+	}
+};
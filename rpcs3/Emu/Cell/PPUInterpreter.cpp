@@ -4,6 +4,7 @@
 #include "Emu/Memory/vm_reservation.h"
 #include "Emu/system_config.h"
 #include "PPUThread.h"
+#include "PPUBlockCache.h"
 #include "Emu/Cell/Common.h"
 #include "Emu/Cell/PPUFunction.h"
 #include "Emu/Cell/timers.hpp"
@@ -4489,8 +4490,11 @@ bool ppu_interpreter::EXTSW(ppu_thread& ppu, ppu_opcode_t op)
 	return true;
 }
 
-bool ppu_interpreter::ICBI(ppu_thread&, ppu_opcode_t)
+bool ppu_interpreter::ICBI(ppu_thread& ppu, ppu_opcode_t op)
 {
+	// Code in this line may have been modified
+	const u64 addr = op.ra ? ppu.gpr[op.ra] + ppu.gpr[op.rb] : ppu.gpr[op.rb];
+	ppu_invalidate_line(vm::cast(addr));
 	return true;
 }
 
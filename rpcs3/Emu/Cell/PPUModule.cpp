@@ -780,6 +780,36 @@ void ppu_manual_load_imports_exports(u32 imports_start, u32 imports_size, u32 ex
 	ppu_load_imports(_main.relocs, &link, imports_start, imports_start + imports_size);
 }
 
+// For the PPU profiler: names of exported functions (code address -> name) and of import table entries (entry address -> name)
+void ppu_get_linkage_names(std::unordered_map<u32, std::string>& exports, std::unordered_map<u32, std::string>& imports)
+{
+	const auto& link = g_fxo->get<ppu_linkage_info>();
+
+	for (const auto& [module_name, mlink] : link.modules)
+	{
+		for (const auto& [fnid, flink] : mlink.functions)
+		{
+			if (!flink.export_addr && flink.imports.empty())
+			{
+				continue;
+			}
+
+			const std::string name = fmt::format("%s.%s", module_name, ppu_get_function_name(module_name, fnid));
+
+			// Exports point to function descriptors
+			if (flink.export_addr && vm::check_addr(flink.export_addr))
+			{
+				exports.emplace(vm::read32(flink.export_addr), name);
+			}
+
+			for (const u32 addr : flink.imports)
+			{
+				imports.emplace(addr, name);
+			}
+		}
+	}
+}
+
 // For savestates
 extern bool is_memory_read_only_of_executable(u32 addr)
 {
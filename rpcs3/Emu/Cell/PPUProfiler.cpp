@@ -0,0 +1,331 @@
+#include "stdafx.h"
+#include "PPUProfiler.h"
+
+#include "Emu/IdManager.h"
+#include "Emu/System.h"
+#include "Emu/system_config.h"
+#include "Emu/Memory/vm.h"
+#include "PPUThread.h"
+#include "PPUFunction.h"
+#include "PPUOpcodes.h"
+#include "lv2/sys_prx.h"
+#include "lv2/sys_overlay.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+extern std::vector<std::string> g_ppu_function_names;
+extern void ppu_get_linkage_names(std::unordered_map<u32, std::string>& exports, std::unordered_map<u32, std::string>& imports);
+
+namespace
+{
+	// Deepest call stack recorded per sample
+	constexpr usz max_stack_depth = 128;
+
+	// Maps guest addresses to function names, built from the modules loaded when the report is written
+	class ppu_symbolizer
+	{
+		struct symbol
+		{
+			u32 addr;
+			u32 size;
+			std::string name;
+		};
+
+		std::vector<symbol> m_functions;
+
+		std::unordered_map<u32, std::string> m_exports;
+		std::unordered_map<u32, std::string> m_imports;
+
+		u32 m_hle_addr = 0;
+
+		// Get the import table entry used by an import stub
+		static u32 get_import_entry(u32 addr)
+		{
+			using namespace ppu_instructions;
+
+			if (!vm::check_addr(addr, vm::page_executable) || !vm::check_addr(addr + 28, vm::page_executable))
+			{
+				return 0;
+			}
+
+			const auto op = [&](u32 index) -> u32 { return vm::read32(addr + index * 4); };
+
+			// li r12,lo; oris r12,r12,hi; lwz r12,disp(r12); ...; lwz r0,0(r12); ...; mtctr r0; bctr
+			if ((op(0) & 0xffff0000) != ADDI(r12, r0, 0) ||
+				(op(1) & 0xffff0000) != ORIS(r12, r12, 0) ||
+				(op(2) & 0xffff0000) != LWZ(r12, r12, 0) ||
+				op(4) != LWZ(r0, r12, 0) ||
+				op(6) != implicts::MTCTR(r0) ||
+				op(7) != implicts::BCTR())
+			{
+				return 0;
+			}
+
+			const u32 base = static_cast<u32>(static_cast<s16>(op(0) & 0xffff)) | (op(1) << 16);
+			return base + static_cast<s16>(op(2) & 0xffff);
+		}
+
+		void add_module(const ppu_module& _module, std::string_view module_name)
+		{
+			for (const auto& func : _module.funcs)
+			{
+				if (!func.size)
+				{
+					continue;
+				}
+
+				std::string name;
+
+				if (const auto found = m_exports.find(func.addr); found != m_exports.end())
+				{
+					name = found->second;
+				}
+				else if (const auto entry = m_imports.find(get_import_entry(func.addr)); entry != m_imports.end())
+				{
+					name = entry->second + " (stub)";
+				}
+				else if (!func.name.empty())
+				{
+					name = func.name;
+				}
+				else
+				{
+					name = fmt::format("%s:sub_%x", module_name, func.addr);
+				}
+
+				m_functions.push_back(symbol{func.addr, func.size, std::move(name)});
+			}
+		}
+
+	public:
+		ppu_symbolizer()
+		{
+			ppu_get_linkage_names(m_exports, m_imports);
+
+			m_hle_addr = g_fxo->get<ppu_function_manager>().addr;
+
+			add_module(g_fxo->get<ppu_module>(), "main");
+
+			idm::select<lv2_obj, lv2_prx>([&](u32, lv2_prx& _module)
+			{
+				add_module(_module, _module.name);
+			});
+
+			idm::select<lv2_obj, lv2_overlay>([&](u32, lv2_overlay& _module)
+			{
+				add_module(_module, _module.name);
+			});
+
+			std::stable_sort(m_functions.begin(), m_functions.end(), [](const symbol& a, const symbol& b)
+			{
+				return a.addr < b.addr;
+			});
+		}
+
+		std::string resolve(u32 addr) const
+		{
+			if (m_hle_addr && addr >= m_hle_addr && (addr - m_hle_addr) / 8 < g_ppu_function_names.size())
+			{
+				// HLE function slots are 8 bytes long
+				if (const auto& name = g_ppu_function_names[(addr - m_hle_addr) / 8]; !name.empty())
+				{
+					return name;
+				}
+			}
+
+			auto found = std::upper_bound(m_functions.begin(), m_functions.end(), addr, [](u32 addr, const symbol& func)
+			{
+				return addr < func.addr;
+			});
+
+			if (found != m_functions.begin() && addr - (--found)->addr < found->size)
+			{
+				return found->name;
+			}
+
+			return fmt::format("0x%08x", addr);
+		}
+	};
+}
+
+void ppu_profiler::operator()()
+{
+	const u32 frequency = g_cfg.core.ppu_profiler_frequency;
+
+	if (!frequency)
+	{
+		return;
+	}
+
+	ppu_log.notice("PPU profiler: Sampling at %u Hz", frequency);
+
+	while (thread_ctrl::state() != thread_state::aborting)
+	{
+		if (!Emu.IsPaused())
+		{
+			sample();
+		}
+
+		thread_ctrl::wait_for(1'000'000 / frequency);
+	}
+
+	report();
+}
+
+void ppu_profiler::sample()
+{
+	std::vector<u32> stack;
+
+	idm::select<named_thread<ppu_thread>>([&](u32 /*id*/, ppu_thread& ppu)
+	{
+		if (auto state = +ppu.state; ::is_paused(state) || ::is_stopped(state) || !(cpu_flag::wait - state))
+		{
+			// Only count threads doing work
+			return;
+		}
+
+		// With the LLVM recompiler CIA is only updated on indirect calls and system calls
+		stack.clear();
+		stack.push_back(ppu.cia);
+
+		for (const auto& [addr, sp] : ppu.dump_callstack_list())
+		{
+			if (stack.size() >= max_stack_depth)
+			{
+				break;
+			}
+
+			stack.push_back(addr);
+		}
+
+		m_stacks[stack]++;
+		m_samples++;
+	});
+}
+
+void ppu_profiler::report() const
+{
+	if (!m_samples)
+	{
+		ppu_log.notice("PPU profiler: No samples were collected");
+		return;
+	}
+
+	const ppu_symbolizer symbols;
+
+	// Resolve every address once
+	std::unordered_map<u32, std::string> names;
+
+	const auto resolve = [&](u32 addr) -> const std::string&
+	{
+		auto [found, inserted] = names.try_emplace(addr);
+
+		if (inserted)
+		{
+			found->second = symbols.resolve(addr);
+		}
+
+		return found->second;
+	};
+
+	// Function name -> samples (self, inclusive)
+	std::unordered_map<std::string_view, std::pair<u64, u64>> functions;
+
+	// Caller first, names separated by ';'
+	std::map<std::string, u64> folded;
+
+	for (const auto& [stack, count] : m_stacks)
+	{
+		std::unordered_set<std::string_view> seen;
+		std::string frames;
+
+		for (usz i = 0; i < stack.size(); i++)
+		{
+			const std::string& name = resolve(stack[i]);
+			auto& [self, inclusive] = functions[name];
+
+			if (i == 0)
+			{
+				self += count;
+			}
+
+			// Recursive functions are counted once
+			if (seen.emplace(name).second)
+			{
+				inclusive += count;
+			}
+		}
+
+		for (auto it = stack.rbegin(); it != stack.rend(); ++it)
+		{
+			std::string name = resolve(*it);
+			std::replace(name.begin(), name.end(), ';', ':');
+			std::replace(name.begin(), name.end(), ' ', '_');
+
+			if (!frames.empty())
+			{
+				frames += ';';
+			}
+
+			frames += name;
+		}
+
+		folded[std::move(frames)] += count;
+	}
+
+	std::vector<std::pair<std::string_view, std::pair<u64, u64>>> sorted(functions.begin(), functions.end());
+
+	std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b)
+	{
+		return a.second.first != b.second.first ? a.second.first > b.second.first : a.second.second > b.second.second;
+	});
+
+	std::string report = fmt::format("PPU profile: %u samples at %u Hz\n", m_samples, g_cfg.core.ppu_profiler_frequency.get());
+	fmt::append(report, "%10s %8s %10s %8s  %s\n", "Self", "Self %", "Inclusive", "Incl. %", "Function");
+
+	for (const auto& [name, counts] : sorted)
+	{
+		fmt::append(report, "%10u %7.2f%% %10u %7.2f%%  %s\n", counts.first, counts.first * 100. / m_samples, counts.second, counts.second * 100. / m_samples, name);
+	}
+
+	const std::string path = fs::get_cache_dir() + "ppu_profile.txt";
+
+	if (fs::file file{ path, fs::rewrite }; file && file.write(report.data(), report.size()) == report.size())
+	{
+		ppu_log.notice("PPU profile written to '%s'", path);
+	}
+	else
+	{
+		ppu_log.error("Failed to write PPU profile to '%s' (%s)", path, fs::g_tls_error);
+	}
+
+	// Input for flamegraph.pl and compatible tools
+	std::string stacks;
+
+	for (const auto& [frames, count] : folded)
+	{
+		fmt::append(stacks, "%s %u\n", frames, count);
+	}
+
+	const std::string folded_path = fs::get_cache_dir() + "ppu_profile.folded";
+
+	if (fs::file file{ folded_path, fs::rewrite }; file && file.write(stacks.data(), stacks.size()) == stacks.size())
+	{
+		ppu_log.notice("PPU folded stacks written to '%s'", folded_path);
+	}
+	else
+	{
+		ppu_log.error("Failed to write PPU folded stacks to '%s' (%s)", folded_path, fs::g_tls_error);
+	}
+
+	// Log the heaviest functions
+	constexpr usz logged_count = 16;
+
+	for (usz i = 0; i < std::min(logged_count, sorted.size()); i++)
+	{
+		const auto& [name, counts] = sorted[i];
+		ppu_log.notice("PPU profile: %s: %.2f%% self, %.2f%% inclusive", name, counts.first * 100. / m_samples, counts.second * 100. / m_samples);
+	}
+}
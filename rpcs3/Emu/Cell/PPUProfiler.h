@@ -0,0 +1,30 @@
+#pragma once
+
+#include "util/types.hpp"
+
+#include <map>
+#include <vector>
+
+// Samples the guest call stacks of running PPU threads at a fixed rate.
+// The reports are written to the cache directory when the emulation stops.
+class ppu_profiler
+{
+	// Call stack (current address first) -> number of samples
+	std::map<std::vector<u32>, u64> m_stacks;
+
+	u64 m_samples = 0;
+
+	void sample();
+	void report() const;
+
+public:
+	ppu_profiler() = default;
+
+	ppu_profiler(const ppu_profiler&) = delete;
+
+	ppu_profiler& operator=(const ppu_profiler&) = delete;
+
+	void operator()();
+
+	static constexpr auto thread_name = "PPU Profiler"sv;
+};
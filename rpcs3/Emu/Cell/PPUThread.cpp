@@ -16,6 +16,7 @@
 #include "PPUThread.h"
 #include "PPUInterpreter.h"
 #include "PPUAnalyser.h"
+#include "PPUBlockCache.h"
 #include "PPUModule.h"
 #include "PPUDisAsm.h"
 #include "SPURecompiler.h"
@@ -141,7 +142,7 @@ const ppu_decoder<ppu_itype> g_ppu_itype;
 extern void ppu_initialize();
 extern void ppu_finalize(const ppu_module& info);
 extern bool ppu_initialize(const ppu_module& info, bool = false);
-static void ppu_initialize2(class jit_compiler& jit, const ppu_module& module_part, const std::string& cache_path, const std::string& obj_name);
+static void ppu_initialize2(class jit_compiler& jit, const ppu_module& module_part, const std::string& cache_path, const std::string& obj_name, bool baseline = false);
 extern std::pair<std::shared_ptr<lv2_overlay>, CellError> ppu_load_overlay(const ppu_exec_object&, const std::string& path, s64 file_offset, utils::serial* = nullptr);
 extern void ppu_unload_prx(const lv2_prx&);
 extern std::shared_ptr<lv2_prx> ppu_load_prx(const ppu_prx_object&, const std::string&, s64 file_offset, utils::serial* = nullptr);
@@ -306,6 +307,21 @@ static bool ppu_fallback(ppu_thread& ppu, ppu_opcode_t op)
 	return false;
 }
 
+extern u64 ppu_get_interpreter_handler(u32 addr)
+{
+	if (ppu_ref(addr) == reinterpret_cast<uptr>(ppu_fallback))
+	{
+		if (g_cfg.core.ppu_debug)
+		{
+			ppu_log.error("Unregistered instruction: 0x%08x", vm::read32(addr));
+		}
+
+		ppu_ref(addr) = ppu_cache(addr);
+	}
+
+	return ppu_ref(addr);
+}
+
 // TODO: Make this a dispatch call
 void ppu_recompiler_fallback(ppu_thread& ppu)
 {
@@ -437,6 +453,8 @@ extern void ppu_register_range(u32 addr, u32 size)
 		addr += 4;
 		size -= 4;
 	}
+
+	ppu_invalidate_blocks();
 }
 
 extern void ppu_register_function_at(u32 addr, u32 size, ppu_function_t ptr)
@@ -445,6 +463,7 @@ extern void ppu_register_function_at(u32 addr, u32 size, ppu_function_t ptr)
 	if (ptr)
 	{
 		ppu_ref(addr) = (reinterpret_cast<uptr>(ptr) & 0x7fff'ffff'ffffu) | (ppu_ref(addr) & ~0x7fff'ffff'ffffu);
+		ppu_invalidate_blocks();
 		return;
 	}
 
@@ -476,6 +495,8 @@ extern void ppu_register_function_at(u32 addr, u32 size, ppu_function_t ptr)
 		addr += 4;
 		size -= 4;
 	}
+
+	ppu_invalidate_blocks();
 }
 
 atomic_t<bool> g_debugger_pause_all_threads_on_bp = true;
@@ -533,6 +554,8 @@ extern void ppu_breakpoint(u32 addr, bool is_adding)
 		// Remove breakpoint
 		ppu_ref(addr) = ppu_cache(addr);
 	}
+
+	ppu_invalidate_blocks();
 }
 
 //sets breakpoint, does nothing if there is a breakpoint there already
@@ -548,6 +571,7 @@ extern void ppu_set_breakpoint(u32 addr)
 	if (ppu_ref(addr) != _break)
 	{
 		ppu_ref(addr) = _break;
+		ppu_invalidate_blocks();
 	}
 }
 
@@ -564,6 +588,7 @@ extern void ppu_remove_breakpoint(u32 addr)
 	if (ppu_ref(addr) == _break)
 	{
 		ppu_ref(addr) = ppu_cache(addr);
+		ppu_invalidate_blocks();
 	}
 }
 
@@ -603,6 +628,8 @@ extern bool ppu_patch(u32 addr, u32 value)
 		{
 			ppu_ref(addr) = ppu_cache(addr);
 		}
+
+		ppu_invalidate_blocks();
 	}
 
 	return true;
@@ -1092,70 +1119,40 @@ void ppu_thread::exec_task()
 	const auto cache = vm::g_exec_addr;
 	using func_t = decltype(&ppu_interpreter::UNK);
 
-	while (true)
+	if (!block_cache)
 	{
-		const auto exec_op = [this](u64 op)
-		{
-			return reinterpret_cast<func_t>(op)(*this, {vm::read32(cia).get()});
-		};
+		block_cache = std::make_unique<ppu_block_cache>();
+	}
+
+	ppu_block_cache& blocks = *block_cache;
+	ppu_block_cache::scope block_scope(blocks);
+
+	// Previously executed block, its successors are linked directly
+	ppu_block* block = nullptr;
 
-		if (cia % 8 || state) [[unlikely]]
+	while (true)
+	{
+		if (state) [[unlikely]]
 		{
 			if (test_stopped()) return;
 
 			// Decode single instruction (may be step)
-			if (exec_op(*reinterpret_cast<u64*>(cache + u64{cia} * 2))) { cia += 4; }
+			if (reinterpret_cast<func_t>(*reinterpret_cast<u64*>(cache + u64{cia} * 2))(*this, {vm::read32(cia).get()})) { cia += 4; }
+			block = nullptr;
 			continue;
 		}
 
-		u64 op0, op1, op2, op3;
-		u64 _pos = u64{cia} * 2;
+		block = blocks.get(block, cia);
 
-		// Reinitialize
+		// Run predecoded instructions until one of them transfers control
+		for (const auto& [func, op] : block->ops)
 		{
-			const v128 _op0 = *reinterpret_cast<const v128*>(cache + _pos);
-			const v128 _op1 = *reinterpret_cast<const v128*>(cache + _pos + 16);
-			op0 = _op0._u64[0];
-			op1 = _op0._u64[1];
-			op2 = _op1._u64[0];
-			op3 = _op1._u64[1];
-		}
-
-		while (exec_op(op0)) [[likely]]
-		{
-			cia += 4;
-
-			if (exec_op(op1)) [[likely]]
+			if (!func(*this, op)) [[unlikely]]
 			{
-				cia += 4;
-
-				if (exec_op(op2)) [[likely]]
-				{
-					cia += 4;
-
-					if (exec_op(op3)) [[likely]]
-					{
-						cia += 4;
-
-						if (state) [[unlikely]]
-						{
-							break;
-						}
-
-						_pos += 32;
-						const v128 _op0 = *reinterpret_cast<const v128*>(cache + _pos);
-						const v128 _op1 = *reinterpret_cast<const v128*>(cache + _pos + 16);
-						op0 = _op0._u64[0];
-						op1 = _op0._u64[1];
-						op2 = _op1._u64[0];
-						op3 = _op1._u64[1];
-						continue;
-					}
-					break;
-				}
 				break;
 			}
-			break;
+
+			cia += 4;
 		}
 	}
 }
@@ -2119,6 +2116,7 @@ static bool ppu_store_reservation(ppu_thread& ppu, u32 addr, u64 reg_value)
 
 	if (old_data != data || rtime != (res & -128))
 	{
+		vm::reservation_record_failure(addr);
 		return false;
 	}
 
@@ -2301,7 +2299,8 @@ static bool ppu_store_reservation(ppu_thread& ppu, u32 addr, u64 reg_value)
 		return false;
 	}())
 	{
-		res.notify_all(-128);
+		vm::reservation_notify(addr);
+		vm::reservation_record_success(addr);
 
 		if (addr == ppu.last_faddr)
 		{
@@ -2312,6 +2311,7 @@ static bool ppu_store_reservation(ppu_thread& ppu, u32 addr, u64 reg_value)
 		return true;
 	}
 
+	vm::reservation_record_failure(addr);
 	return false;
 }
 
@@ -2334,6 +2334,9 @@ namespace
 		std::vector<ppu_function_t> funcs;
 		std::shared_ptr<jit_compiler> pjit;
 		bool init = false;
+
+		// Compiler instances of the parts recompiled by ppu_llvm_tier
+		std::vector<std::shared_ptr<jit_compiler>> tiers;
 	};
 
 	struct jit_module_manager
@@ -2362,6 +2365,260 @@ namespace
 			map.erase(found);
 		}
 	};
+
+	// Object file name of the baseline tier for the given module part
+	std::string ppu_get_baseline_name(const std::string& obj_name)
+	{
+		return obj_name.substr(0, obj_name.size() - 4) + "-tier0.obj";
+	}
+
+	// Recompiles the module parts compiled by the baseline tier with full optimizations, most used first
+	struct ppu_llvm_tier
+	{
+		struct task
+		{
+			// Key in jit_module_manager
+			std::string module_key;
+
+			std::string cache_path;
+			std::string obj_name;
+
+			// Functions to recompile (made of consecutive functions of the module)
+			ppu_module part;
+			u32 start = 0;
+			u32 end = 0;
+
+			// Addresses of the module functions, in the order of jit_module::funcs
+			std::shared_ptr<const std::vector<u32>> module_funcs;
+			u32 reloc = 0;
+
+			const std::unordered_map<std::string, u64>* link_table = nullptr;
+
+			// Number of times the code of this part was found on a PPU thread call stack
+			u64 samples = 0;
+		};
+
+		// Held while a recompiled module part is installed
+		shared_mutex busy;
+
+		shared_mutex mutex;
+		std::vector<std::unique_ptr<task>> tasks;
+		atomic_t<u32> added = 0;
+
+		// Module of the task being recompiled, the result is dropped if the module is removed meanwhile (protected by mutex)
+		std::string current_module;
+		bool current_removed = false;
+
+		void push(std::unique_ptr<task> _task)
+		{
+			{
+				std::lock_guard lock(mutex);
+				tasks.emplace_back(std::move(_task));
+			}
+
+			added++;
+			added.notify_one();
+		}
+
+		// Cancel pending tasks of the module being unloaded
+		void remove(const std::string& module_key)
+		{
+			// Only waits for an installation in progress, not for the compilation
+			std::lock_guard lock(busy);
+			std::lock_guard lock2(mutex);
+
+			if (current_module == module_key)
+			{
+				current_removed = true;
+			}
+
+			tasks.erase(std::remove_if(tasks.begin(), tasks.end(), [&](const std::unique_ptr<task>& _task)
+			{
+				return _task->module_key == module_key;
+			}), tasks.end());
+		}
+
+		bool empty()
+		{
+			reader_lock lock(mutex);
+			return tasks.empty();
+		}
+
+		void sample()
+		{
+			std::vector<u32> stack;
+
+			idm::select<named_thread<ppu_thread>>([&](u32 /*id*/, ppu_thread& ppu)
+			{
+				if (auto state = +ppu.state; ::is_paused(state) || ::is_stopped(state) || !(cpu_flag::wait - state))
+				{
+					return;
+				}
+
+				// Baseline code updates CIA on every call
+				stack.clear();
+				stack.push_back(ppu.cia);
+
+				for (const auto& [addr, sp] : ppu.dump_callstack_list())
+				{
+					if (stack.size() >= 32)
+					{
+						break;
+					}
+
+					stack.push_back(addr);
+				}
+
+				std::lock_guard lock(mutex);
+
+				for (auto& _task : tasks)
+				{
+					if (std::any_of(stack.begin(), stack.end(), [&](u32 addr) { return addr >= _task->start && addr < _task->end; }))
+					{
+						_task->samples++;
+					}
+				}
+			});
+		}
+
+		void install(const task& _task)
+		{
+			auto& jit_mod = g_fxo->get<jit_module_manager>().get(_task.module_key);
+
+			const auto& module_funcs = *_task.module_funcs;
+			ensure(module_funcs.size() == jit_mod.funcs.size());
+
+			std::unordered_map<u32, usz> index;
+			index.reserve(module_funcs.size());
+
+			for (usz i = 0; i < module_funcs.size(); i++)
+			{
+				index.emplace(module_funcs[i], i);
+			}
+
+			// Link with the current code of the rest of the module
+			std::unordered_map<std::string, u64> link_table = *_task.link_table;
+
+			for (usz i = 0; i < module_funcs.size(); i++)
+			{
+				if (module_funcs[i] < _task.start || module_funcs[i] >= _task.end)
+				{
+					link_table.emplace(fmt::format("__0x%x", module_funcs[i] - _task.reloc), reinterpret_cast<u64>(jit_mod.funcs[i]));
+				}
+			}
+
+			auto jit = std::make_shared<jit_compiler>(link_table, g_cfg.core.llvm_cpu);
+			jit->set_profiler_prefix(fmt::format("PPU %s ", _task.part.name.empty() ? "main" : _task.part.name));
+			jit->add(_task.cache_path + _task.obj_name);
+			jit->fin();
+
+			for (const auto& func : _task.part.funcs)
+			{
+				if (!func.size) continue;
+
+				const u64 addr = ensure(jit->get(func.name));
+				auto& old = jit_mod.funcs[index.at(func.addr)];
+
+				// Leave the function alone if something else was installed meanwhile (breakpoint, another module)
+				if ((ppu_ref(func.addr) & 0x7fff'ffff'ffffu) == reinterpret_cast<uptr>(old))
+				{
+					ppu_ref(func.addr) = (addr & 0x7fff'ffff'ffffu) | (ppu_ref(func.addr) & ~0x7fff'ffff'ffffu);
+				}
+
+				old = reinterpret_cast<ppu_function_t>(addr);
+			}
+
+			jit_mod.tiers.emplace_back(std::move(jit));
+		}
+
+		void operator()()
+		{
+			while (thread_ctrl::state() != thread_state::aborting && !Emu.IsStopped())
+			{
+				const u32 old = added;
+
+				if (empty())
+				{
+					thread_ctrl::wait_on(added, old);
+					continue;
+				}
+
+				// Find the hot code
+				for (u32 i = 0; i < 16 && thread_ctrl::state() != thread_state::aborting; i++)
+				{
+					sample();
+					thread_ctrl::wait_for(5000);
+				}
+
+				std::unique_ptr<task> _task;
+				{
+					std::lock_guard lock2(mutex);
+
+					if (tasks.empty())
+					{
+						continue;
+					}
+
+					const auto found = std::max_element(tasks.begin(), tasks.end(), [](const std::unique_ptr<task>& a, const std::unique_ptr<task>& b)
+					{
+						return a->samples < b->samples;
+					});
+
+					_task = std::move(*found);
+					tasks.erase(found);
+
+					current_module = _task->module_key;
+					current_removed = false;
+				}
+
+				// The module may have been unloaded without finalization
+				if (!vm::check_addr(_task->start, vm::page_executable, _task->end - _task->start))
+				{
+					continue;
+				}
+
+				ppu_log.warning("LLVM: Recompiling module %s%s (%u samples)", _task->cache_path, _task->obj_name, _task->samples);
+
+				{
+					// Set low priority
+					thread_ctrl::scoped_priority low_prio(-1);
+
+					jit_compiler jit2({}, g_cfg.core.llvm_cpu, 0x1);
+					ppu_initialize2(jit2, _task->part, _task->cache_path, _task->obj_name);
+				}
+
+				if (Emu.IsStopped() || !jit_compiler::check(_task->cache_path + _task->obj_name))
+				{
+					continue;
+				}
+
+				{
+					std::lock_guard lock(busy);
+					{
+						std::lock_guard lock2(mutex);
+
+						const bool removed = std::exchange(current_removed, false);
+						current_module.clear();
+
+						if (removed)
+						{
+							ppu_log.notice("LLVM: Discarded recompiled module %s of an unloaded module", _task->obj_name);
+							continue;
+						}
+					}
+
+					install(*_task);
+				}
+
+				// The baseline object is not needed anymore
+				fs::remove_file(_task->cache_path + ppu_get_baseline_name(_task->obj_name));
+
+				ppu_log.success("LLVM: Installed recompiled module %s", _task->obj_name);
+			}
+		}
+
+		static constexpr auto thread_name = "PPU LLVM Tier"sv;
+	};
 }
 #endif
 
@@ -2475,6 +2732,11 @@ extern void ppu_finalize(const ppu_module& info)
 	}
 
 #ifdef LLVM_AVAILABLE
+	if (auto tier = g_fxo->try_get<named_thread<ppu_llvm_tier>>())
+	{
+		tier->remove(cache_path + info.name);
+	}
+
 	g_fxo->get<jit_module_manager>().remove(cache_path + info.name);
 #endif
 }
@@ -2900,6 +3162,7 @@ bool ppu_initialize(const ppu_module& info, bool check_only)
 			}
 		}
 
+		ppu_invalidate_blocks();
 		return false;
 	}
 
@@ -3016,6 +3279,12 @@ bool ppu_initialize(const ppu_module& info, bool check_only)
 	// Sync variable to acquire workloads
 	atomic_t<u32> work_cv = 0;
 
+	// Compile new code quickly and recompile it in the background (only when it's going to be executed)
+	const bool tiered = g_cfg.core.ppu_llvm_tiered && !check_only && get_current_cpu_thread();
+
+	// Module parts to recompile with full optimizations
+	std::vector<std::pair<std::string, ppu_module>> tier_workload;
+
 	bool compiled_new = false;
 
 	while (!jit_mod.init && fpos < info.funcs.size())
@@ -3024,6 +3293,7 @@ bool ppu_initialize(const ppu_module& info, bool check_only)
 		if (!jit && get_current_cpu_thread())
 		{
 			jit = std::make_shared<jit_compiler>(s_link_table, g_cfg.core.llvm_cpu);
+			jit->set_profiler_prefix(fmt::format("PPU %s ", info.name.empty() ? "main" : info.name));
 		}
 
 		// Copy module information (TODO: optimize)
@@ -3231,6 +3501,15 @@ bool ppu_initialize(const ppu_module& info, bool check_only)
 			return true;
 		}
 
+		if (tiered && jit_compiler::check(cache_path + ppu_get_baseline_name(obj_name)))
+		{
+			ppu_log.success("LLVM: Baseline module exists: %s", obj_name);
+
+			link_workload.back().first = ppu_get_baseline_name(obj_name);
+			tier_workload.emplace_back(std::move(obj_name), std::move(part));
+			continue;
+		}
+
 		// Remember, used in ppu_initialize(void)
 		compiled_new = true;
 
@@ -3289,8 +3568,16 @@ bool ppu_initialize(const ppu_module& info, bool check_only)
 				ppu_log.warning("LLVM: Compiling module %s%s", cache_path, obj_name);
 
 				// Use another JIT instance
-				jit_compiler jit2({}, g_cfg.core.llvm_cpu, 0x1);
-				ppu_initialize2(jit2, part, cache_path, obj_name);
+				if (tiered)
+				{
+					jit_compiler jit2({}, g_cfg.core.llvm_cpu, 0x1 | 0x4);
+					ppu_initialize2(jit2, part, cache_path, ppu_get_baseline_name(obj_name), true);
+				}
+				else
+				{
+					jit_compiler jit2({}, g_cfg.core.llvm_cpu, 0x1);
+					ppu_initialize2(jit2, part, cache_path, obj_name);
+				}
 
 				ppu_log.success("LLVM: Compiled module %s", obj_name);
 			}
@@ -3318,6 +3605,11 @@ bool ppu_initialize(const ppu_module& info, bool check_only)
 				break;
 			}
 
+			if (tiered && is_compiled)
+			{
+				obj_name = ppu_get_baseline_name(obj_name);
+			}
+
 			jit->add(cache_path + obj_name);
 
 			if (!is_compiled)
@@ -3353,6 +3645,49 @@ bool ppu_initialize(const ppu_module& info, bool check_only)
 		}
 
 		jit_mod.init = true;
+
+		if (tiered)
+		{
+			for (auto& [obj_name, part] : workload)
+			{
+				tier_workload.emplace_back(std::move(obj_name), std::move(part));
+			}
+		}
+
+		if (!tier_workload.empty())
+		{
+			auto module_funcs = std::make_shared<std::vector<u32>>();
+
+			for (const auto& func : info.funcs)
+			{
+				if (func.size)
+				{
+					module_funcs->push_back(func.addr);
+				}
+			}
+
+			auto& tier = g_fxo->get<named_thread<ppu_llvm_tier>>();
+
+			for (auto& [obj_name, part] : tier_workload)
+			{
+				if (part.funcs.empty())
+				{
+					continue;
+				}
+
+				auto _task = std::make_unique<ppu_llvm_tier::task>();
+				_task->module_key = cache_path + info.name;
+				_task->cache_path = cache_path;
+				_task->obj_name = std::move(obj_name);
+				_task->start = part.funcs.front().addr;
+				_task->end = part.funcs.back().addr + part.funcs.back().size;
+				_task->part = std::move(part);
+				_task->module_funcs = module_funcs;
+				_task->reloc = reloc;
+				_task->link_table = &s_link_table;
+				tier.push(std::move(_task));
+			}
+		}
 	}
 	else
 	{
@@ -3379,7 +3714,7 @@ bool ppu_initialize(const ppu_module& info, bool check_only)
 #endif
 }
 
-static void ppu_initialize2(jit_compiler& jit, const ppu_module& module_part, const std::string& cache_path, const std::string& obj_name)
+static void ppu_initialize2(jit_compiler& jit, const ppu_module& module_part, const std::string& cache_path, const std::string& obj_name, bool baseline)
 {
 #ifdef LLVM_AVAILABLE
 	using namespace llvm;
@@ -3392,7 +3727,7 @@ static void ppu_initialize2(jit_compiler& jit, const ppu_module& module_part, co
 	_module->setDataLayout(jit.get_engine().getTargetMachine()->createDataLayout());
 
 	// Initialize translator
-	PPUTranslator translator(jit.get_context(), _module.get(), module_part, jit.get_engine());
+	PPUTranslator translator(jit.get_context(), _module.get(), module_part, jit.get_engine(), baseline);
 
 	// Define some types
 	const auto _func = FunctionType::get(translator.get_type<void>(), {
@@ -3454,8 +3789,11 @@ static void ppu_initialize2(jit_compiler& jit, const ppu_module& module_part, co
 				// Translate
 				if (const auto func = translator.Translate(module_part.funcs[fi]))
 				{
-					// Run optimization passes
-					pm.run(*func);
+					// Run optimization passes (skipped by the baseline tier)
+					if (!baseline)
+					{
+						pm.run(*func);
+					}
 				}
 				else
 				{
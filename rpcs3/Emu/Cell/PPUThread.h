@@ -300,6 +300,9 @@ public:
 
 	u32 dbg_step_pc = 0;
 
+	// Predecoded blocks of the interpreter
+	std::unique_ptr<class ppu_block_cache> block_cache;
+
 	// For named_thread ctor
 	const struct thread_name_t
 	{
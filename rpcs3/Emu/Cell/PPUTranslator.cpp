@@ -18,10 +18,11 @@ const ppu_decoder<PPUTranslator> s_ppu_decoder;
 const ppu_decoder<ppu_itype> s_ppu_itype;
 const ppu_decoder<ppu_iname> s_ppu_iname;
 
-PPUTranslator::PPUTranslator(LLVMContext& context, Module* _module, const ppu_module& info, ExecutionEngine& engine)
+PPUTranslator::PPUTranslator(LLVMContext& context, Module* _module, const ppu_module& info, ExecutionEngine& engine, bool baseline)
 	: cpu_translator(_module, false)
 	, m_info(info)
 	, m_pure_attr(AttributeList::get(m_context, AttributeList::FunctionIndex, {Attribute::NoUnwind, Attribute::ReadNone}))
+	, m_baseline(baseline)
 {
 	// Bind context
 	cpu_translator::initialize(context, engine);
@@ -343,6 +344,18 @@ void PPUTranslator::CallFunction(u64 target, Value* indirect)
 
 	auto seg0 = m_seg0;
 
+	if (!indirect && m_baseline)
+	{
+		if ((!m_reloc && target < 0x10000) || target >= 0x100000000u - 0x10000)
+		{
+			Trap();
+			return;
+		}
+
+		// Call through the function table, so the functions recompiled in the background are picked up
+		indirect = m_reloc ? m_ir->CreateAdd(m_ir->getInt64(target), m_seg0) : m_ir->getInt64(target);
+	}
+
 	if (!indirect)
 	{
 		if ((!m_reloc && target < 0x10000) || target >= 0x100000000u - 0x10000)
@@ -34,6 +34,9 @@ class PPUTranslator final : public cpu_translator
 	// Set by instruction code after processing the relocation
 	const ppu_reloc* m_rel = nullptr;
 
+	// Baseline tier code (see ppu_llvm_tiered)
+	const bool m_baseline;
+
 	/* Variables */
 
 	// Memory base
@@ -331,7 +334,7 @@ public:
 	// Handle compilation errors
 	void CompilationError(const std::string& error);
 
-	PPUTranslator(llvm::LLVMContext& context, llvm::Module* _module, const ppu_module& info, llvm::ExecutionEngine& engine);
+	PPUTranslator(llvm::LLVMContext& context, llvm::Module* _module, const ppu_module& info, llvm::ExecutionEngine& engine, bool baseline = false);
 	~PPUTranslator();
 
 	// Get thread context struct type
@@ -89,6 +89,7 @@ bool spu_thread::read_reg(const u32 addr, u32& value)
 			{
 				// Perform transfer immediately
 				do_dma_transfer(nullptr, cmd, ls);
+				ls_written(cmd.lsa, cmd.size);
 			}
 
 			if (cmd.cmd & MFC_START_MASK)
@@ -184,13 +184,26 @@ spu_function_t spu_recompiler::compile(spu_program&& _func)
 		}
 	}
 
+	// Tiered mode: SPU LLVM replaces this function by patching a jump here
+	m_is_tier = g_cfg.core.spu_decoder == spu_decoder_type::llvm;
+
+	if (m_is_tier)
+	{
+		// 8-byte instruction for patching (long NOP)
+		c->dq(0x841f0f);
+
+		// Identify the program for the SPU LLVM profiler
+		c->mov(x86::rax, m_hash_start);
+		c->mov(SPU_OFF_64(block_hash), x86::rax);
+	}
+
 	// Load actual PC and check status
 	c->sub(x86::rsp, 0x28);
 	c->mov(pc0->r32(), SPU_OFF_32(pc));
 	c->cmp(SPU_OFF_32(state), 0);
 	c->jnz(label_stop);
 
-	if (g_cfg.core.spu_prof && g_cfg.core.spu_verification)
+	if (!m_is_tier && g_cfg.core.spu_prof && g_cfg.core.spu_verification)
 	{
 		c->mov(x86::rax, m_hash_start & -0xffff);
 		c->mov(SPU_OFF_64(block_hash), x86::rax);
@@ -758,10 +771,10 @@ spu_function_t spu_recompiler::compile(spu_program&& _func)
 	// Acknowledge success and add statistics
 	c->add(SPU_OFF_64(block_counter), ::size32(words) / (words_align / 4));
 
-	// Set block hash for profiling (if enabled)
+	// Set block hash for profiling (if enabled), as the first tier keep the key used by the SPU LLVM profiler
 	if (g_cfg.core.spu_prof)
 	{
-		c->mov(x86::rax, m_hash_start | 0xffff);
+		c->mov(x86::rax, m_is_tier ? m_hash_start : m_hash_start | 0xffff);
 		c->mov(SPU_OFF_64(block_hash), x86::rax);
 	}
 
@@ -905,6 +918,8 @@ spu_function_t spu_recompiler::compile(spu_program&& _func)
 		spu_log.fatal("Failed to build a function");
 	}
 
+	jit_announce(fn, code.getCodeSize(), fmt::format("spu-0x%05x-%s [ASMJIT]", func.entry_point, fmt::base57(be_t<u64>{m_hash_start})));
+
 	// Install compiled function pointer
 	const bool added = !add_loc->compiled && add_loc->compiled.compare_and_swap_test(nullptr, fn);
 
@@ -917,6 +932,12 @@ spu_function_t spu_recompiler::compile(spu_program&& _func)
 	if (added)
 	{
 		add_loc->compiled.notify_all();
+
+		if (m_is_tier)
+		{
+			// Send work to LLVM compiler thread
+			enqueue_llvm(m_hash_start, add_loc);
+		}
 	}
 
 	if (g_cfg.core.spu_debug && added)
@@ -1216,7 +1237,7 @@ void spu_recompiler::branch_set_link(u32 target)
 				// Set block hash for profiling (if enabled)
 				if (g_cfg.core.spu_prof)
 				{
-					c->mov(x86::rax, m_hash_start | 0xffff);
+					c->mov(x86::rax, m_is_tier ? m_hash_start : m_hash_start | 0xffff);
 					c->mov(SPU_OFF_64(block_hash), x86::rax);
 				}
 
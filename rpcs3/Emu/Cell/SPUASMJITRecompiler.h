@@ -23,6 +23,9 @@ private:
 
 	u32 m_base;
 
+	// Compiling the first tier of SPU LLVM
+	bool m_is_tier = false;
+
 	// emitter:
 	asmjit::X86Assembler* c;
 
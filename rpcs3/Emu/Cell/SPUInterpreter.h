@@ -2,6 +2,10 @@
 
 #include "SPUOpcodes.h"
 
+#include "util/atomic.hpp"
+
+#include <array>
+
 class spu_thread;
 
 using spu_inter_func_t = bool(*)(spu_thread& spu, spu_opcode_t op);
@@ -247,3 +251,71 @@ struct spu_interpreter_precise final : spu_interpreter
 	static bool FMA(spu_thread&, spu_opcode_t);
 	static bool FMS(spu_thread&, spu_opcode_t);
 };
+
+// Local storage predecoded for the interpreter, 128-byte lines are decoded on first execution
+class spu_decoded_ls
+{
+public:
+	struct entry
+	{
+		spu_inter_func_t func;
+		spu_opcode_t op;
+	};
+
+	static constexpr u32 line_size = 128;
+	static constexpr u32 line_count = 0x40000 / line_size;
+
+private:
+	// Bit per decoded line (can be cleared by other threads)
+	std::array<atomic_t<u64>, line_count / 64> m_valid{};
+
+	std::array<entry, 0x40000 / 4> m_ops;
+
+	void decode(const u8* ls, u32 line);
+
+public:
+	// Get predecoded instruction at pc
+	const entry& get(const u8* ls, u32 pc)
+	{
+		const u32 line = pc / line_size;
+
+		if (!(m_valid[line / 64].load() & (1ull << (line % 64)))) [[unlikely]]
+		{
+			decode(ls, line);
+		}
+
+		return m_ops[pc / 4];
+	}
+
+	// Must be called after the local storage was modified
+	void invalidate(u32 lsa, u32 size)
+	{
+		if (!size)
+		{
+			return;
+		}
+
+		const u32 first = (lsa % 0x40000) / line_size;
+		const u32 count = std::min<u32>((lsa % line_size + size + line_size - 1) / line_size, line_count);
+
+		for (u32 i = 0; i < count; i++)
+		{
+			const u32 line = (first + i) % line_count;
+			const u64 bit = 1ull << (line % 64);
+
+			// Only lines containing executed code need an atomic update
+			if (m_valid[line / 64].load() & bit)
+			{
+				m_valid[line / 64] &= ~bit;
+			}
+		}
+	}
+
+	void invalidate_all()
+	{
+		for (auto& bits : m_valid)
+		{
+			bits.release(0);
+		}
+	}
+};
@@ -357,6 +357,101 @@ void spu_cache::add(const spu_program& func)
 	m_file.write_gather(gather, 3);
 }
 
+void spu_profile::load(const std::string& path)
+{
+	std::lock_guard lock(m_mutex);
+
+	m_samples.clear();
+	m_path = path;
+
+	fs::file file(path);
+
+	if (!file)
+	{
+		return;
+	}
+
+	if (file.size() % 16)
+	{
+		spu_log.error("SPU profile is damaged: %s", path);
+		return;
+	}
+
+	// Records of (hash, samples) pairs
+	const auto data = file.to_vector<be_t<u64>>();
+
+	for (usz i = 0; i < data.size(); i += 2)
+	{
+		m_samples.emplace(data[i], data[i + 1]);
+	}
+
+	spu_log.notice("Loaded SPU profile with %u programs: %s", m_samples.size(), path);
+}
+
+u64 spu_profile::get(u64 hash) const
+{
+	reader_lock lock(m_mutex);
+
+	const auto found = m_samples.find(hash);
+	return found != m_samples.end() ? found->second : 0;
+}
+
+void spu_profile::save(const std::unordered_map<u64, u64, value_hash<u64>>& samples)
+{
+	std::lock_guard lock(m_mutex);
+
+	if (m_path.empty())
+	{
+		return;
+	}
+
+	// Add the programs first seen in this run, with no weight from previous runs
+	for (const auto& [hash, count] : samples)
+	{
+		if (count)
+		{
+			m_samples.emplace(hash, 0);
+		}
+	}
+
+	// Halve the weight of previous runs so that the profile follows changes in the workload
+	for (auto it = m_samples.begin(); it != m_samples.end();)
+	{
+		const u64 old = it->second;
+		const auto found = samples.find(it->first);
+
+		// Samples of this run were seeded with the old value
+		it->second = found != samples.end() ? found->second - std::min(found->second, old) + old / 2 : old / 2;
+
+		if (!it->second)
+		{
+			it = m_samples.erase(it);
+			continue;
+		}
+
+		++it;
+	}
+
+	std::vector<be_t<u64>> data;
+	data.reserve(m_samples.size() * 2);
+
+	for (const auto& [hash, count] : m_samples)
+	{
+		data.push_back(hash);
+		data.push_back(count);
+	}
+
+	fs::pending_file file(m_path);
+
+	if (!file.file || file.file.write(data.data(), data.size() * sizeof(data[0])) != data.size() * sizeof(data[0]) || !file.commit())
+	{
+		spu_log.error("Failed to save SPU profile: %s (%s)", m_path, fs::g_tls_error);
+		return;
+	}
+
+	spu_log.notice("Saved SPU profile with %u programs: %s", m_samples.size(), m_path);
+}
+
 void spu_cache::initialize()
 {
 	spu_runtime::g_interpreter = spu_runtime::g_gateway;
@@ -379,6 +474,9 @@ void spu_cache::initialize()
 	// SPU cache file (version + block size type)
 	const std::string loc = ppu_cache + "spu-" + fmt::to_lower(g_cfg.core.spu_block_size.to_string()) + "-v1-tane.dat";
 
+	// Hotness of the cached programs, collected by the SPU LLVM profiler
+	g_fxo->get<spu_profile>().load(ppu_cache + "spu-" + fmt::to_lower(g_cfg.core.spu_block_size.to_string()) + "-v1-profile.dat");
+
 	spu_cache cache(loc);
 
 	if (!cache)
@@ -437,6 +535,9 @@ void spu_cache::initialize()
 		// Initialize compiler instances for parallel compilation
 		std::unique_ptr<spu_recompiler_base> compiler;
 
+		// ASMJIT instance for the programs which were cold on previous runs (tiered mode)
+		std::unique_ptr<spu_recompiler_base> baseline;
+
 		if (g_cfg.core.spu_decoder == spu_decoder_type::asmjit)
 		{
 			compiler = spu_recompiler_base::make_asmjit_recompiler();
@@ -444,10 +545,18 @@ void spu_cache::initialize()
 		else if (g_cfg.core.spu_decoder == spu_decoder_type::llvm)
 		{
 			compiler = spu_recompiler_base::make_llvm_recompiler();
+
+			if (g_cfg.core.spu_llvm_asmjit_tier)
+			{
+				baseline = spu_recompiler_base::make_asmjit_recompiler();
+				baseline->init();
+			}
 		}
 
 		compiler->init();
 
+		auto& profile = g_fxo->get<spu_profile>();
+
 		// How much every thread compiled
 		uint result = 0;
 
@@ -496,14 +605,17 @@ void spu_cache::initialize()
 				ls[pos / 4] = std::bit_cast<be_t<u32>>(func.data[i]);
 			}
 
+			// Programs not sampled on previous runs start with ASMJIT, SPU LLVM replaces them once they run
+			auto& tier = baseline && !profile.get(hash_start) ? baseline : compiler;
+
 			// Call analyser
-			spu_program func2 = compiler->analyse(ls.data(), func.entry_point);
+			spu_program func2 = tier->analyse(ls.data(), func.entry_point);
 
 			if (func2 != func)
 			{
 				spu_log.error("[0x%05x] SPU Analyser failed, %u vs %u", func2.entry_point, func2.data.size(), size0);
 			}
-			else if (!compiler->compile(std::move(func2)))
+			else if (!tier->compile(std::move(func2)))
 			{
 				// Likely, out of JIT memory. Signal to prevent further building.
 				fail_flag |= 1;
@@ -1180,6 +1292,24 @@ void spu_recompiler_base::branch(spu_thread& spu, void*, u8* rip)
 	spu_runtime::g_tail_escape(&spu, func, rip);
 }
 
+void spu_decoded_ls::decode(const u8* ls, u32 line)
+{
+	// Select opcode table
+	const auto& table = *(g_cfg.core.spu_decoder == spu_decoder_type::precise
+		? &g_spu_interpreter_precise.get_table()
+		: &g_spu_interpreter_fast.get_table());
+
+	// Mark the line first: a concurrent write clears it again after modifying the data
+	m_valid[line / 64] |= 1ull << (line % 64);
+
+	for (u32 i = 0; i < line_size / 4; i++)
+	{
+		const u32 pos = line * (line_size / 4) + i;
+		const u32 op = reinterpret_cast<const be_t<u32>*>(ls)[pos];
+		m_ops[pos] = {table[spu_decode(op)], {op}};
+	}
+}
+
 void spu_recompiler_base::old_interpreter(spu_thread& spu, void* ls, u8* /*rip*/)
 {
 	if (g_cfg.core.spu_decoder > spu_decoder_type::fast)
@@ -1187,14 +1317,14 @@ void spu_recompiler_base::old_interpreter(spu_thread& spu, void* ls, u8* /*rip*/
 		fmt::throw_exception("Invalid SPU decoder");
 	}
 
-	// Select opcode table
-	const auto& table = *(g_cfg.core.spu_decoder == spu_decoder_type::precise
-		? &g_spu_interpreter_precise.get_table()
-		: &g_spu_interpreter_fast.get_table());
-
 	// LS pointer
 	const auto base = static_cast<const u8*>(ls);
 
+	auto& decoded = *ensure(spu.decoded_ls.get());
+
+	// Local storage could be modified by untracked writers while the thread was not running
+	decoded.invalidate_all();
+
 	while (true)
 	{
 		if (spu.state) [[unlikely]]
@@ -1203,8 +1333,9 @@ void spu_recompiler_base::old_interpreter(spu_thread& spu, void* ls, u8* /*rip*/
 				break;
 		}
 
-		const u32 op = *reinterpret_cast<const be_t<u32>*>(base + spu.pc);
-		if (table[spu_decode(op)](spu, {op}))
+		const auto& [func, op] = decoded.get(base, spu.pc);
+
+		if (func(spu, op))
 			spu.pc += 4;
 	}
 }
@@ -9232,6 +9363,7 @@ struct spu_llvm
 	{
 		// Dependency
 		g_fxo->init<spu_cache>();
+		g_fxo->init<spu_profile>();
 	}
 
 	void operator()()
@@ -9245,6 +9377,9 @@ struct spu_llvm
 		// For synchronization with profiler thread
 		stx::init_mutex prof_mutex;
 
+		// Samples of previous runs
+		auto& profile = g_fxo->get<spu_profile>();
+
 		named_thread profiler("SPU LLVM Profiler"sv, [&]()
 		{
 			while (thread_ctrl::state() != thread_state::aborting)
@@ -9302,8 +9437,8 @@ struct spu_llvm
 				// Interrupt and kick profiler thread
 				const auto lock = prof_mutex.init_always([&]{});
 
-				// Register new blocks to collect samples
-				samples.emplace(pair.first, 0);
+				// Register new blocks to collect samples, starting from the samples of previous runs
+				samples.emplace(pair.first, profile.get(pair.first));
 			}
 
 			if (enqueued.empty())
@@ -9342,7 +9477,18 @@ struct spu_llvm
 			(workers.begin() + (worker_index++ % worker_count))->registered.push(reinterpret_cast<u64>(_old), &func);
 		}
 
-		static_cast<void>(prof_mutex.init_always([&]{ samples.clear(); }));
+		static_cast<void>(prof_mutex.init_always([&]
+		{
+			std::unordered_map<u64, u64, value_hash<u64>> result;
+
+			for (const auto& [hash, count] : samples)
+			{
+				result.emplace(hash, count.load());
+			}
+
+			profile.save(result);
+			samples.clear();
+		}));
 
 		for (u32 i = 0; i < worker_count; i++)
 		{
@@ -9355,6 +9501,21 @@ struct spu_llvm
 
 using spu_llvm_thread = named_thread<spu_llvm>;
 
+void spu_recompiler_base::enqueue_llvm(u64 hash_start, spu_item* item)
+{
+	// Check hash against allowed bounds
+	const bool inverse_bounds = g_cfg.core.spu_llvm_lower_bound > g_cfg.core.spu_llvm_upper_bound;
+
+	if ((!inverse_bounds && (hash_start < g_cfg.core.spu_llvm_lower_bound || hash_start > g_cfg.core.spu_llvm_upper_bound)) ||
+		(inverse_bounds && (hash_start < g_cfg.core.spu_llvm_lower_bound && hash_start > g_cfg.core.spu_llvm_upper_bound)))
+	{
+		spu_log.error("[Debug] Skipped function %s", fmt::base57(be_t<u64>{hash_start}));
+		return;
+	}
+
+	g_fxo->get<spu_llvm_thread>().registered.push(hash_start, item);
+}
+
 struct spu_fast : public spu_recompiler_base
 {
 	virtual void init() override
@@ -9683,23 +9844,12 @@ struct spu_fast : public spu_recompiler_base
 
 		const auto fn = reinterpret_cast<spu_function_t>(result);
 
+		// The LLVM build of the same function is reported as well once it replaces this one
+		jit_announce(result, raw - result, fmt::format("spu-0x%05x-%s [fast]", func.entry_point, fmt::base57(be_t<u64>{m_hash_start})));
+
 		// Install pointer carefully
 		const bool added = !add_loc->compiled && add_loc->compiled.compare_and_swap_test(nullptr, fn);
 
-		// Check hash against allowed bounds
-		const bool inverse_bounds = g_cfg.core.spu_llvm_lower_bound > g_cfg.core.spu_llvm_upper_bound;
-
-		if ((!inverse_bounds && (m_hash_start < g_cfg.core.spu_llvm_lower_bound || m_hash_start > g_cfg.core.spu_llvm_upper_bound)) ||
-			(inverse_bounds && (m_hash_start < g_cfg.core.spu_llvm_lower_bound && m_hash_start > g_cfg.core.spu_llvm_upper_bound)))
-		{
-			spu_log.error("[Debug] Skipped function %s", fmt::base57(be_t<u64>{m_hash_start}));
-		}
-		else if (added)
-		{
-			// Send work to LLVM compiler thread
-			g_fxo->get<spu_llvm_thread>().registered.push(m_hash_start, add_loc);
-		}
-
 		// Rebuild trampoline if necessary
 		if (!m_spurt->rebuild_ubertrampoline(func.data[0]))
 		{
@@ -9709,6 +9859,9 @@ struct spu_fast : public spu_recompiler_base
 		if (added)
 		{
 			add_loc->compiled.notify_all();
+
+			// Send work to LLVM compiler thread
+			enqueue_llvm(m_hash_start, add_loc);
 		}
 
 		return fn;
@@ -9,6 +9,7 @@
 #include <memory>
 #include <string>
 #include <deque>
+#include <unordered_map>
 
 // Helper class
 class spu_cache
@@ -38,6 +39,26 @@ public:
 	static void initialize();
 };
 
+// Persistent SPU program hotness (hash -> profiler samples), saved next to the SPU cache
+class spu_profile
+{
+	mutable shared_mutex m_mutex;
+
+	std::unordered_map<u64, u64, value_hash<u64>> m_samples;
+
+	std::string m_path;
+
+public:
+	// Load the profile of the current title
+	void load(const std::string& path);
+
+	// Get the number of samples recorded on previous runs
+	u64 get(u64 hash) const;
+
+	// Merge the samples of the current run (including the values returned by get()) and write the file
+	void save(const std::unordered_map<u64, u64, value_hash<u64>>& samples);
+};
+
 struct spu_program
 {
 	// Address of the entry point in LS
@@ -340,4 +361,7 @@ public:
 
 	// Create recompiler instance (interpreter-based LLVM)
 	static std::unique_ptr<spu_recompiler_base> make_fast_llvm_recompiler();
+
+	// Queue a baseline function for replacement by SPU LLVM (it must start with an 8-byte patch point)
+	static void enqueue_llvm(u64 hash_start, spu_item* item);
 };
@@ -1776,7 +1776,8 @@ spu_thread::spu_thread(lv2_spu_group* group, u32 index, std::string_view name, u
 
 	if (g_cfg.core.spu_decoder == spu_decoder_type::llvm)
 	{
-		jit = spu_recompiler_base::make_fast_llvm_recompiler();
+		// First tier, SPU LLVM replaces the hot programs later
+		jit = g_cfg.core.spu_llvm_asmjit_tier ? spu_recompiler_base::make_asmjit_recompiler() : spu_recompiler_base::make_fast_llvm_recompiler();
 	}
 
 	if (g_cfg.core.spu_decoder != spu_decoder_type::fast && g_cfg.core.spu_decoder != spu_decoder_type::precise)
@@ -1787,6 +1788,10 @@ spu_thread::spu_thread(lv2_spu_group* group, u32 index, std::string_view name, u
 			std::memset(stack_mirror.data(), 0xff, sizeof(stack_mirror));
 		}
 	}
+	else
+	{
+		decoded_ls = std::make_unique<spu_decoded_ls>();
+	}
 
 	if (get_type() >= spu_type::raw)
 	{
@@ -1882,7 +1887,8 @@ spu_thread::spu_thread(utils::serial& ar, lv2_spu_group* group)
 
 	if (g_cfg.core.spu_decoder == spu_decoder_type::llvm)
 	{
-		jit = spu_recompiler_base::make_fast_llvm_recompiler();
+		// First tier, SPU LLVM replaces the hot programs later
+		jit = g_cfg.core.spu_llvm_asmjit_tier ? spu_recompiler_base::make_asmjit_recompiler() : spu_recompiler_base::make_fast_llvm_recompiler();
 	}
 
 	if (g_cfg.core.spu_decoder != spu_decoder_type::fast && g_cfg.core.spu_decoder != spu_decoder_type::precise)
@@ -1893,6 +1899,10 @@ spu_thread::spu_thread(utils::serial& ar, lv2_spu_group* group)
 			std::memset(stack_mirror.data(), 0xff, sizeof(stack_mirror));
 		}
 	}
+	else
+	{
+		decoded_ls = std::make_unique<spu_decoded_ls>();
+	}
 
 	if (get_type() >= spu_type::raw)
 	{
@@ -2081,6 +2091,22 @@ void spu_thread::do_dma_transfer(spu_thread* _this, const spu_mfc_cmd& args, u8*
 	u32 eal = args.eal;
 	u32 lsa = args.lsa & 0x3ffff;
 
+	// Invalidate the interpreter instructions of the LS written by the transfer once it's done
+	struct ls_write_notifier
+	{
+		spu_thread* spu;
+		u32 lsa;
+		u32 size;
+
+		~ls_write_notifier()
+		{
+			if (spu)
+			{
+				spu->ls_written(lsa, size);
+			}
+		}
+	} ls_write{is_get ? _this : nullptr, lsa, args.size};
+
 	// Keep src point to const
 	u8* dst = nullptr;
 	const u8* src = nullptr;
@@ -2149,7 +2175,11 @@ void spu_thread::do_dma_transfer(spu_thread* _this, const spu_mfc_cmd& args, u8*
 				if (auto ptr = spu.ls + offset; is_get)
 					src = ptr;
 				else
+				{
 					dst = ptr;
+					ls_write.spu = &spu;
+					ls_write.lsa = offset;
+				}
 			}
 			else if (!is_get && args.size == 4 && (offset == SYS_SPU_THREAD_SNR1 || offset == SYS_SPU_THREAD_SNR2))
 			{
@@ -2213,17 +2243,15 @@ void spu_thread::do_dma_transfer(spu_thread* _this, const spu_mfc_cmd& args, u8*
 		{
 			size0 = std::min<u32>(128 - (eal & 127), std::min<u32>(size, 128));
 
-			for (u64 i = 0;; [&]()
+			vm::reservation_backoff backoff(eal);
+
+			for (;; [&]()
 			{
 				if (_cpu->state)
 				{
 					_cpu->check_state();
 				}
-				else if (++i < 25) [[likely]]
-				{
-					busy_wait(300);
-				}
-				else
+				else if (!backoff.spin()) [[unlikely]]
 				{
 					_cpu->state += cpu_flag::wait + cpu_flag::temp;
 					std::this_thread::yield();
@@ -2364,6 +2392,8 @@ void spu_thread::do_dma_transfer(spu_thread* _this, const spu_mfc_cmd& args, u8*
 
 				u128 old = 0;
 
+				vm::reservation_backoff backoff(eal);
+
 				for (u64 i = 0; i != umax; [&]()
 				{
 					if (_cpu->state & cpu_flag::pause)
@@ -2383,11 +2413,7 @@ void spu_thread::do_dma_transfer(spu_thread* _this, const spu_mfc_cmd& args, u8*
 						}
 					}
 
-					if (++i < 10)
-					{
-						busy_wait(500);
-					}
-					else
+					if (!backoff.spin())
 					{
 						// Wait
 						_cpu->state += cpu_flag::wait + cpu_flag::temp;
@@ -3042,7 +3068,8 @@ bool spu_thread::do_putllc(const spu_mfc_cmd& args)
 		return success;
 	}())
 	{
-		vm::reservation_notifier(addr).notify_all(-128);
+		vm::reservation_notify(addr);
+		vm::reservation_record_success(addr);
 		raddr = 0;
 		perf0.reset();
 		return true;
@@ -3054,6 +3081,7 @@ bool spu_thread::do_putllc(const spu_mfc_cmd& args)
 			// Last check for event before we clear the reservation
 			if (raddr == addr)
 			{
+				vm::reservation_record_failure(addr);
 				set_events(SPU_EVENT_LR);
 			}
 			else
@@ -3147,7 +3175,7 @@ void spu_thread::do_putlluc(const spu_mfc_cmd& args)
 	}
 
 	do_cell_atomic_128_store(addr, _ptr<spu_rdata_t>(args.lsa & 0x3ff80));
-	vm::reservation_notifier(addr).notify_all(-128);
+	vm::reservation_notify(addr);
 }
 
 void spu_thread::do_mfc(bool /*wait*/)
@@ -3336,6 +3364,9 @@ bool spu_thread::process_mfc_cmd()
 		const u32 addr = ch_mfc_cmd.eal & -128;
 		const auto& data = vm::_ref<spu_rdata_t>(addr);
 
+		// Reservation data is written to the LS by this thread
+		ls_written(ch_mfc_cmd.lsa & 0x3ff80, 128);
+
 		if (addr == last_faddr)
 		{
 			// TODO: make this configurable and possible to disable
@@ -3377,6 +3408,8 @@ bool spu_thread::process_mfc_cmd()
 			mov_rdata(temp, rdata);
 		}
 
+		vm::reservation_backoff backoff(addr);
+
 		for (u64 i = 0; i != umax; [&]()
 		{
 			if (state & cpu_flag::pause)
@@ -3399,11 +3432,9 @@ bool spu_thread::process_mfc_cmd()
 				}
 			}
 
-			if (++i < 25) [[likely]]
-			{
-				busy_wait(300);
-			}
-			else
+			i++;
+
+			if (!backoff.spin()) [[unlikely]]
 			{
 				state += cpu_flag::wait + cpu_flag::temp;
 				std::this_thread::yield();
@@ -4078,7 +4109,7 @@ s64 spu_thread::get_ch_value(u32 ch)
 					continue;
 				}
 
-				vm::reservation_notifier(raddr).wait(rtime, -128, atomic_wait_timeout{100'000});
+				vm::reservation_wait(raddr, rtime, 100'000);
 			}
 
 			check_state();
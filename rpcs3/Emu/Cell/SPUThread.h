@@ -756,6 +756,7 @@ public:
 	atomic_ptr<std::string> spu_tname;
 
 	std::unique_ptr<class spu_recompiler_base> jit; // Recompiler instance
+	std::unique_ptr<spu_decoded_ls> decoded_ls; // Interpreter instruction cache
 
 	u64 block_counter = 0;
 	u64 block_recover = 0;
@@ -810,6 +811,15 @@ public:
 
 	bool capture_local_storage() const;
 
+	// Notify the interpreter that the LS was written (after the write)
+	void ls_written(u32 lsa, u32 size)
+	{
+		if (decoded_ls) [[unlikely]]
+		{
+			decoded_ls->invalidate(lsa, size);
+		}
+	}
+
 	// Convert specified SPU LS address to a pointer of specified (possibly converted to BE) type
 	template<typename T>
 	to_be_t<T>* _ptr(u32 lsa) const
@@ -1402,6 +1402,8 @@ error_code sys_spu_thread_write_ls(ppu_thread& ppu, u32 id, u32 lsa, u64 value,
 	default: fmt::throw_exception("Unreachable");
 	}
 
+	thread->ls_written(lsa, type);
+
 	return CELL_OK;
 }
 
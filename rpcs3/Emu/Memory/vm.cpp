@@ -18,6 +18,7 @@
 
 #include "util/vm.hpp"
 #include "util/asm.hpp"
+#include "util/sysinfo.hpp"
 #include "util/v128sse.hpp"
 #include "util/serialization.hpp"
 
@@ -61,6 +62,17 @@ namespace vm
 	// Reservation stats
 	alignas(4096) u8 g_reservations[65536 / 128 * 64]{0};
 
+	// Reservation contention stats
+	alignas(64) reservation_stats g_reservation_stats[65536 / 128]{};
+
+	// Reservation line waiters
+	reservation_waiter_set g_reservation_waiters[65536 / 128]{};
+
+	atomic_t<u32> g_reservation_waiters_overflow{0};
+
+	// Reservation wait statistics: all waits, waits ended by a store to the line, waits which didn't fit in the waiter set
+	atomic_t<u64> g_reservation_waits{0}, g_reservation_waits_notified{0}, g_reservation_waits_overflow{0};
+
 	// Pointers to shared memory mirror or zeros for "normal" memory
 	alignas(4096) atomic_t<u64> g_shmem[65536]{0};
 
@@ -110,7 +122,7 @@ namespace vm
 			{
 				if (ok)
 				{
-					reservation_notifier(addr).notify_all();
+					reservation_notify(addr);
 				}
 
 				return;
@@ -553,9 +565,106 @@ namespace vm
 		g_mutex.unlock();
 	}
 
+	std::vector<reservation_stats_info> reservation_get_contended(usz count)
+	{
+		std::vector<reservation_stats_info> result;
+
+		for (auto& stats : g_reservation_stats)
+		{
+			if (const u64 failures = stats.failures, retries = stats.retries; failures || retries)
+			{
+				result.push_back({stats.addr, failures, retries, stats.wait_ticks});
+			}
+		}
+
+		std::sort(result.begin(), result.end(), [](const reservation_stats_info& a, const reservation_stats_info& b)
+		{
+			return a.failures != b.failures ? a.failures > b.failures : a.wait_ticks > b.wait_ticks;
+		});
+
+		if (result.size() > count)
+		{
+			result.resize(count);
+		}
+
+		return result;
+	}
+
+	void reservation_wait(u32 addr, u64 rtime, u64 timeout)
+	{
+		const u32 line = (addr & -128) | 1;
+		auto& res = reservation_acquire(addr);
+
+		g_reservation_waits++;
+
+		for (auto& waiter : g_reservation_waiters[(addr & 0xff80) / 128].waiters)
+		{
+			if (!waiter.addr.compare_and_swap_test(0, line))
+			{
+				continue;
+			}
+
+			const u32 signal = waiter.signal;
+
+			// Check the timestamp again after registration, the store may have been done already
+			if ((res & -128) == (rtime & -128))
+			{
+				waiter.signal.wait(signal, atomic_wait_timeout{timeout});
+			}
+
+			if (waiter.signal != signal)
+			{
+				g_reservation_waits_notified++;
+			}
+
+			waiter.addr.release(0);
+			return;
+		}
+
+		// All entries are taken: wait on the reservation itself, woken by any store which uses it
+		g_reservation_waits_overflow++;
+		g_reservation_waiters_overflow++;
+		res.wait(rtime, -128, atomic_wait_timeout{timeout});
+		g_reservation_waiters_overflow--;
+	}
+
+	void reservation_report_stats(bool reset)
+	{
+		const f64 tsc_freq = static_cast<f64>(utils::get_tsc_freq());
+
+		if (const u64 waits = g_reservation_waits)
+		{
+			perf_log.notice("Reservation waits: %u, %u ended by a store to the line, %u on the shared notifier", waits, +g_reservation_waits_notified, +g_reservation_waits_overflow);
+		}
+
+		for (const auto& info : reservation_get_contended(16))
+		{
+			perf_log.notice(u8"Reservation contention at 0x%x: %u failures, %u retries, %.3fµs waiting", info.addr, info.failures, info.retries,
+				tsc_freq ? info.wait_ticks / (tsc_freq / 1000'000.) : 0.);
+		}
+
+		if (reset)
+		{
+			for (auto& stats : g_reservation_stats)
+			{
+				stats.addr.release(0);
+				stats.heat.release(0);
+				stats.failures.release(0);
+				stats.retries.release(0);
+				stats.wait_ticks.release(0);
+			}
+
+			g_reservation_waits.release(0);
+			g_reservation_waits_notified.release(0);
+			g_reservation_waits_overflow.release(0);
+		}
+	}
+
 	u64 reservation_lock_internal(u32 addr, atomic_t<u64>& res)
 	{
-		for (u64 i = 0;; i++)
+		reservation_backoff backoff(addr);
+
+		while (true)
 		{
 			if (u64 rtime = res; !(rtime & 127) && reservation_try_lock(res, rtime)) [[likely]]
 			{
@@ -566,11 +675,7 @@ namespace vm
 			{
 				cpu->check_state();
 			}
-			else if (i < 15)
-			{
-				busy_wait(500);
-			}
-			else
+			else if (!backoff.spin())
 			{
 				// TODO: Accurate locking in this case
 				if (!(g_pages[addr / 4096] & page_writable))
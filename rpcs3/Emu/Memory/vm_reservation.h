@@ -3,7 +3,9 @@
 #include "vm.h"
 #include "vm_locking.h"
 #include "util/atomic.hpp"
+#include "util/asm.hpp"
 #include <functional>
+#include <vector>
 
 extern bool g_use_rtm;
 extern u64 g_rtm_tx_limit2;
@@ -51,6 +53,161 @@ namespace vm
 		return *reinterpret_cast<atomic_t<u64>*>(g_reservations + (addr & 0xff80) / 2);
 	}
 
+	// Thread waiting for a store to a reservation line
+	struct reservation_waiter
+	{
+		// Address of the line | 1, or 0 if the entry is free
+		atomic_t<u32> addr;
+
+		// Incremented on every store to the line
+		atomic_t<u32> signal;
+	};
+
+	// Waiters of all lines which use the same reservation (lines are compared precisely, so they don't wake each other)
+	struct alignas(64) reservation_waiter_set
+	{
+		reservation_waiter waiters[8];
+	};
+
+	extern reservation_waiter_set g_reservation_waiters[65536 / 128];
+
+	// Number of threads waiting on reservation_notifier because their waiter set was full
+	extern atomic_t<u32> g_reservation_waiters_overflow;
+
+	// Wake the threads waiting for a store to the line at addr (must be called after the reservation timestamp is updated)
+	inline void reservation_notify(u32 addr)
+	{
+		const u32 line = (addr & -128) | 1;
+
+		for (auto& waiter : g_reservation_waiters[(addr & 0xff80) / 128].waiters)
+		{
+			if (waiter.addr == line) [[unlikely]]
+			{
+				waiter.signal++;
+				waiter.signal.notify_all();
+			}
+		}
+
+		if (g_reservation_waiters_overflow) [[unlikely]]
+		{
+			reservation_notifier(addr).notify_all(-128);
+		}
+	}
+
+	// Wait for a store to the line at addr while the reservation timestamp equals rtime, timeout is in nanoseconds
+	void reservation_wait(u32 addr, u64 rtime, u64 timeout);
+
+	// Contention statistics of a reservation (shared by all addresses which use the same reservation)
+	struct reservation_stats
+	{
+		// Last contended address
+		atomic_t<u32> addr;
+
+		// Recent contention level: raised by failed conditional stores, lowered by successful ones
+		atomic_t<u32> heat;
+
+		// Failed conditional stores (STWCX, STDCX, PUTLLC)
+		atomic_t<u64> failures;
+
+		// Iterations and time (TSC ticks) spent waiting for the reservation lock
+		atomic_t<u64> retries;
+		atomic_t<u64> wait_ticks;
+	};
+
+	extern reservation_stats g_reservation_stats[65536 / 128];
+
+	inline reservation_stats& reservation_get_stats(u32 addr)
+	{
+		return g_reservation_stats[(addr & 0xff80) / 128];
+	}
+
+	// Record a conditional store which failed because the reservation was lost
+	inline void reservation_record_failure(u32 addr)
+	{
+		auto& stats = reservation_get_stats(addr);
+		stats.addr.release(addr & -128);
+		stats.failures++;
+		stats.heat.fetch_op([](u32& heat)
+		{
+			heat = std::min<u32>(heat + 1, 64);
+		});
+	}
+
+	// Record a successful conditional store
+	inline void reservation_record_success(u32 addr)
+	{
+		auto& stats = reservation_get_stats(addr);
+
+		if (stats.heat) [[unlikely]]
+		{
+			stats.heat.fetch_op([](u32& heat)
+			{
+				heat -= !!heat;
+			});
+		}
+	}
+
+	// Waiting policy for a locked reservation: exponentially growing spins, then yielding to the OS.
+	// Less spinning is done on reservations which were contended recently.
+	class reservation_backoff
+	{
+		reservation_stats& m_stats;
+		const u64 m_start;
+		const u64 m_limit;
+		u64 m_spent = 0;
+		u32 m_count = 0;
+
+	public:
+		explicit reservation_backoff(u32 addr) noexcept
+			: m_stats(reservation_get_stats(addr))
+			, m_start(get_tsc())
+			, m_limit(m_stats.heat < 16 ? 8192 : 2048)
+		{
+		}
+
+		reservation_backoff(const reservation_backoff&) = delete;
+
+		reservation_backoff& operator=(const reservation_backoff&) = delete;
+
+		// Spin once, returns false if the caller should yield instead
+		bool spin() noexcept
+		{
+			const u64 cycles = 128 << std::min<u32>(m_count++, 5);
+
+			if (m_spent + cycles > m_limit)
+			{
+				return false;
+			}
+
+			m_spent += cycles;
+			busy_wait(cycles);
+			return true;
+		}
+
+		~reservation_backoff()
+		{
+			if (m_count)
+			{
+				m_stats.retries += m_count;
+				m_stats.wait_ticks += get_tsc() - m_start;
+			}
+		}
+	};
+
+	struct reservation_stats_info
+	{
+		u32 addr;
+		u64 failures;
+		u64 retries;
+		u64 wait_ticks;
+	};
+
+	// Get statistics of the most contended reservations, ordered by failures and time spent waiting
+	std::vector<reservation_stats_info> reservation_get_contended(usz count);
+
+	// Log the most contended reservations
+	void reservation_report_stats(bool reset);
+
 	u64 reservation_lock_internal(u32, atomic_t<u64>&);
 
 	void reservation_shared_lock_internal(atomic_t<u64>&);
@@ -143,7 +300,7 @@ namespace vm
 					_xend();
 #endif
 					if constexpr (Ack)
-						res.notify_all(-128);
+						reservation_notify(addr);
 					return;
 				}
 				else
@@ -157,7 +314,7 @@ namespace vm
 						_xend();
 #endif
 						if constexpr (Ack)
-							res.notify_all(-128);
+							reservation_notify(addr);
 						return result;
 					}
 					else
@@ -212,7 +369,7 @@ namespace vm
 #endif
 					res += 127;
 					if (Ack)
-						res.notify_all(-128);
+						reservation_notify(addr);
 					return;
 				}
 				else
@@ -226,7 +383,7 @@ namespace vm
 #endif
 						res += 127;
 						if (Ack)
-							res.notify_all(-128);
+							reservation_notify(addr);
 						return result;
 					}
 					else
@@ -261,7 +418,7 @@ namespace vm
 				});
 
 				if constexpr (Ack)
-					res.notify_all(-128);
+					reservation_notify(addr);
 				return;
 			}
 			else
@@ -281,7 +438,7 @@ namespace vm
 				});
 
 				if (Ack && result)
-					res.notify_all(-128);
+					reservation_notify(addr);
 				return result;
 			}
 		}
@@ -298,7 +455,7 @@ namespace vm
 			}
 
 			if constexpr (Ack)
-				res.notify_all(-128);
+				reservation_notify(addr);
 			return;
 		}
 		else
@@ -318,7 +475,7 @@ namespace vm
 			}
 
 			if (Ack && result)
-				res.notify_all(-128);
+				reservation_notify(addr);
 			return result;
 		}
 	}
@@ -410,7 +567,7 @@ namespace vm
 
 			if constexpr (Ack)
 			{
-				res.notify_all(-128);
+				reservation_notify(addr);
 			}
 		}
 		else
@@ -420,7 +577,7 @@ namespace vm
 
 			if constexpr (Ack)
 			{
-				res.notify_all(-128);
+				reservation_notify(addr);
 			}
 
 			return result;
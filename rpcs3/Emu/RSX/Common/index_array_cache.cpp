@@ -0,0 +1,186 @@
+#include "stdafx.h"
+#include "index_array_cache.h"
+#include "BufferUtils.h"
+#include "page_lock_table.h"
+
+namespace rsx
+{
+	index_array_cache::~index_array_cache()
+	{
+		purge();
+	}
+
+	void index_array_cache::release_pages(const utils::address_range& range)
+	{
+		for (u32 page = range.start; page < range.end; page += 4096)
+		{
+			auto found = m_locked_pages.find(page);
+			if (found == m_locked_pages.end())
+			{
+				// Already released by a write fault
+				continue;
+			}
+
+			if (--found->second == 0)
+			{
+				m_locked_pages.erase(found);
+				page_lock_table.unlock_range(page_lock_owner::index_cache, utils::address_range::start_length(page, 4096));
+			}
+		}
+	}
+
+	void index_array_cache::remove_entry(decltype(m_entries)::iterator it)
+	{
+		release_pages(it->second.source_range);
+		m_cached_bytes -= it->second.data.size();
+		m_entries.erase(it);
+	}
+
+	void index_array_cache::evict_one()
+	{
+		auto oldest = m_entries.begin();
+		for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
+		{
+			if (it->second.last_used < oldest->second.last_used)
+			{
+				oldest = it;
+			}
+		}
+
+		remove_entry(oldest);
+	}
+
+	void index_array_cache::process_invalidated_ranges()
+	{
+		if (!page_lock_table.has_invalidated_ranges(page_lock_owner::index_cache)) [[likely]]
+		{
+			return;
+		}
+
+		for (const auto& invalidated : page_lock_table.take_invalidated_ranges(page_lock_owner::index_cache))
+		{
+			for (u32 page = invalidated.start; page < invalidated.end; page += 4096)
+			{
+				// The fault handler already dropped the lock on this page, but it may have been locked again since
+				m_locked_pages.erase(page);
+				page_lock_table.unlock_range(page_lock_owner::index_cache, utils::address_range::start_length(page, 4096));
+
+				if (u8& count = m_page_invalidations[page]; count < max_page_invalidations)
+				{
+					count++;
+				}
+			}
+
+			for (auto it = m_entries.begin(); it != m_entries.end();)
+			{
+				if (it->second.source_range.overlaps(invalidated))
+				{
+					auto next = std::next(it);
+					remove_entry(it);
+					it = next;
+				}
+				else
+				{
+					++it;
+				}
+			}
+		}
+	}
+
+	bool index_array_cache::is_cacheable(const utils::address_range& range) const
+	{
+		for (u32 page = range.start; page < range.end; page += 4096)
+		{
+			if (const auto found = m_page_invalidations.find(page);
+				found != m_page_invalidations.end() && found->second >= max_page_invalidations)
+			{
+				// Dynamic data, not worth the page faults
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	std::tuple<u32, u32, u32> index_array_cache::write_index_array_data_to_buffer(std::span<std::byte> dst, std::span<const std::byte> src, u32 address,
+		rsx::index_array_type type, rsx::primitive_type draw_mode, bool restart_index_enabled, u32 restart_index,
+		const std::function<bool(rsx::primitive_type)>& expands)
+	{
+		const u32 count = static_cast<u32>(src.size_bytes() / get_index_type_size(type));
+
+		if (!m_enabled || !address || count < min_cached_index_count)
+		{
+			return ::write_index_array_data_to_buffer(dst, src, type, draw_mode, restart_index_enabled, restart_index, expands);
+		}
+
+		process_invalidated_ranges();
+
+		const key_type key
+		{
+			.address = address,
+			.count = count,
+			.restart_index = restart_index_enabled ? restart_index : 0,
+			.type = type,
+			.draw_mode = draw_mode,
+			.restart_index_enabled = restart_index_enabled,
+			.expands = expands(draw_mode)
+		};
+
+		if (auto found = m_entries.find(key); found != m_entries.end())
+		{
+			auto& entry = found->second;
+			if (entry.data.size() == dst.size_bytes()) [[likely]]
+			{
+				std::memcpy(dst.data(), entry.data.data(), dst.size_bytes());
+				entry.last_used = ++m_use_counter;
+				return entry.result;
+			}
+
+			// Destination layout changed, rebuild
+			remove_entry(found);
+		}
+
+		const auto source_range = utils::address_range::start_length(address, ::size32(src)).to_page_range();
+		if (!is_cacheable(source_range) || dst.size_bytes() > max_cached_bytes)
+		{
+			return ::write_index_array_data_to_buffer(dst, src, type, draw_mode, restart_index_enabled, restart_index, expands);
+		}
+
+		// Lock before the data is read so that any later write is caught
+		page_lock_table.lock_range(page_lock_owner::index_cache, source_range);
+
+		for (u32 page = source_range.start; page < source_range.end; page += 4096)
+		{
+			m_locked_pages[page]++;
+		}
+
+		const auto result = ::write_index_array_data_to_buffer(dst, src, type, draw_mode, restart_index_enabled, restart_index, expands);
+
+		while (!m_entries.empty() && (m_entries.size() >= max_entries || (m_cached_bytes + dst.size_bytes()) > max_cached_bytes))
+		{
+			evict_one();
+		}
+
+		auto& entry = m_entries[key];
+		entry.data.assign(dst.begin(), dst.end());
+		entry.result = result;
+		entry.source_range = source_range;
+		entry.last_used = ++m_use_counter;
+		m_cached_bytes += dst.size_bytes();
+
+		return result;
+	}
+
+	void index_array_cache::purge()
+	{
+		for (const auto& page : m_locked_pages)
+		{
+			page_lock_table.unlock_range(page_lock_owner::index_cache, utils::address_range::start_length(page.first, 4096));
+		}
+
+		m_entries.clear();
+		m_locked_pages.clear();
+		m_page_invalidations.clear();
+		m_cached_bytes = 0;
+	}
+}
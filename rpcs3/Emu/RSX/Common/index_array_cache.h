@@ -0,0 +1,95 @@
+#pragma once
+
+#include "../gcm_enums.h"
+#include "Utilities/address_range.h"
+
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace rsx
+{
+	/**
+	 * Small hashed cache of index buffer analysis results.
+	 * Keeps the min/max range and the converted (swapped, expanded) indices of static index buffers so that
+	 * repeated draws of the same mesh skip the full index pass. Source pages are write protected through the
+	 * page lock table and cached entries are dropped as soon as the guest writes to them.
+	 */
+	class index_array_cache
+	{
+		// Small index buffers are cheaper to process than to track
+		static constexpr u32 min_cached_index_count = 128;
+		static constexpr u32 max_entries = 256;
+		static constexpr usz max_cached_bytes = 32 * 0x100000;
+
+		// Pages written to this many times are considered dynamic and are no longer cached
+		static constexpr u8 max_page_invalidations = 4;
+
+		struct key_type
+		{
+			u32 address;
+			u32 count;
+			u32 restart_index;
+			rsx::index_array_type type;
+			rsx::primitive_type draw_mode;
+			bool restart_index_enabled;
+			bool expands;
+
+			bool operator==(const key_type&) const = default;
+		};
+
+		struct key_hasher
+		{
+			usz operator()(const key_type& key) const noexcept
+			{
+				u64 hash = (u64{key.address} << 32) | key.count;
+				hash ^= (u64{key.restart_index} * 0x9E3779B97F4A7C15ull);
+				hash ^= (u64{static_cast<u8>(key.type)} << 8) | (u64{static_cast<u8>(key.draw_mode)} << 16) |
+					(u64{key.restart_index_enabled} << 24) | (u64{key.expands} << 25);
+				return static_cast<usz>(hash ^ (hash >> 29));
+			}
+		};
+
+		struct entry_type
+		{
+			std::vector<std::byte> data; // Converted indices exactly as written to the destination buffer
+			std::tuple<u32, u32, u32> result;
+			utils::address_range source_range;
+			u64 last_used;
+		};
+
+		std::unordered_map<key_type, entry_type, key_hasher> m_entries;
+		std::unordered_map<u32, u32> m_locked_pages;      // Page address -> number of entries built from it
+		std::unordered_map<u32, u8> m_page_invalidations; // Page address -> number of times entries were invalidated by a write
+
+		usz m_cached_bytes = 0;
+		u64 m_use_counter = 0;
+		const bool m_enabled;
+
+		void release_pages(const utils::address_range& range);
+		void remove_entry(decltype(m_entries)::iterator it);
+		void evict_one();
+		void process_invalidated_ranges();
+		bool is_cacheable(const utils::address_range& range) const;
+
+	public:
+		explicit index_array_cache(bool enabled)
+			: m_enabled(enabled)
+		{}
+
+		~index_array_cache();
+
+		index_array_cache(const index_array_cache&) = delete;
+		index_array_cache& operator=(const index_array_cache&) = delete;
+
+		/**
+		 * Same contract as write_index_array_data_to_buffer.
+		 * address is the guest address of src, or 0 if the indices did not come from guest memory (immediate mode).
+		 */
+		std::tuple<u32, u32, u32> write_index_array_data_to_buffer(std::span<std::byte> dst, std::span<const std::byte> src, u32 address,
+			rsx::index_array_type type, rsx::primitive_type draw_mode, bool restart_index_enabled, u32 restart_index,
+			const std::function<bool(rsx::primitive_type)>& expands);
+
+		void purge();
+	};
+}
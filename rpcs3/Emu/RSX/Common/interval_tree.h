@@ -0,0 +1,265 @@
+#pragma once
+
+#include "../rsx_utils.h"
+
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace rsx
+{
+	/**
+	 * Index of address ranges for overlap queries, shared by the texture cache and the surface store.
+	 * Implemented as a treap ordered on the range start, each node carrying the highest range end of its subtree.
+	 * Queries cost O(log n + k) and visit the overlapping entries in ascending start address order.
+	 * Each value is stored at most once, inserting a value that is already present moves it to the new range.
+	 * The index must not be modified from inside a query callback.
+	 */
+	template <typename T, typename Hash = std::hash<T>>
+	class interval_tree
+	{
+		static constexpr u32 nil = umax;
+
+		struct node
+		{
+			u32 start;
+			u32 end;
+			u32 max_end;
+			u32 priority;
+			u32 left;
+			u32 right;
+			T value;
+		};
+
+		std::vector<node> m_nodes;
+		std::vector<u32> m_free_list;
+		std::unordered_map<T, u32, Hash> m_lookup;
+		u32 m_root = nil;
+		u32 m_seed = 0x9E3779B9;
+
+		u32 next_priority()
+		{
+			// xorshift32, only has to be cheap and reasonably uniform
+			m_seed ^= m_seed << 13;
+			m_seed ^= m_seed >> 17;
+			m_seed ^= m_seed << 5;
+			return m_seed;
+		}
+
+		// Nodes are ordered on (start, index) so that identical ranges are still distinct keys
+		bool is_less(u32 a, u32 start, u32 index) const
+		{
+			const auto& n = m_nodes[a];
+			return n.start < start || (n.start == start && a < index);
+		}
+
+		void update(u32 t)
+		{
+			auto& n = m_nodes[t];
+			n.max_end = n.end;
+
+			if (n.left != nil)
+			{
+				n.max_end = std::max(n.max_end, m_nodes[n.left].max_end);
+			}
+
+			if (n.right != nil)
+			{
+				n.max_end = std::max(n.max_end, m_nodes[n.right].max_end);
+			}
+		}
+
+		// Splits t into the nodes ordered before (start, index) and the rest
+		void split(u32 t, u32 start, u32 index, u32& left, u32& right)
+		{
+			if (t == nil)
+			{
+				left = right = nil;
+				return;
+			}
+
+			if (is_less(t, start, index))
+			{
+				split(m_nodes[t].right, start, index, m_nodes[t].right, right);
+				left = t;
+			}
+			else
+			{
+				split(m_nodes[t].left, start, index, left, m_nodes[t].left);
+				right = t;
+			}
+
+			update(t);
+		}
+
+		// All the nodes of left must be ordered before the nodes of right
+		u32 merge(u32 left, u32 right)
+		{
+			if (left == nil) return right;
+			if (right == nil) return left;
+
+			if (m_nodes[left].priority > m_nodes[right].priority)
+			{
+				m_nodes[left].right = merge(m_nodes[left].right, right);
+				update(left);
+				return left;
+			}
+
+			m_nodes[right].left = merge(left, m_nodes[right].left);
+			update(right);
+			return right;
+		}
+
+		void unlink(u32 index)
+		{
+			u32 left, middle, right;
+			split(m_root, m_nodes[index].start, index, left, middle);
+			split(middle, m_nodes[index].start, index + 1, middle, right);
+
+			ensure(middle == index);
+			m_root = merge(left, right);
+		}
+
+		template <typename F>
+		bool visit(u32 t, const address_range& range, F& func) const
+		{
+			if (t == nil || m_nodes[t].max_end < range.start)
+			{
+				// Nothing in this subtree reaches the range
+				return true;
+			}
+
+			const auto& n = m_nodes[t];
+
+			if (!visit(n.left, range, func))
+			{
+				return false;
+			}
+
+			if (n.start > range.end)
+			{
+				// This node and everything to its right starts past the range
+				return true;
+			}
+
+			if (n.end >= range.start)
+			{
+				if constexpr (std::is_same_v<std::invoke_result_t<F&, const T&>, bool>)
+				{
+					if (!func(n.value))
+					{
+						return false;
+					}
+				}
+				else
+				{
+					func(n.value);
+				}
+			}
+
+			return visit(n.right, range, func);
+		}
+
+	public:
+		interval_tree() = default;
+
+		void insert(const address_range& range, const T& value)
+		{
+			AUDIT(range.valid());
+
+			u32 index;
+			if (const auto found = m_lookup.find(value); found != m_lookup.end())
+			{
+				index = found->second;
+				unlink(index);
+			}
+			else
+			{
+				if (m_free_list.empty())
+				{
+					index = ::size32(m_nodes);
+					m_nodes.emplace_back();
+				}
+				else
+				{
+					index = m_free_list.back();
+					m_free_list.pop_back();
+				}
+
+				m_lookup.emplace(value, index);
+			}
+
+			auto& n = m_nodes[index];
+			n.start = range.start;
+			n.end = range.end;
+			n.max_end = range.end;
+			n.priority = next_priority();
+			n.left = nil;
+			n.right = nil;
+			n.value = value;
+
+			u32 left, right;
+			split(m_root, range.start, index, left, right);
+			m_root = merge(merge(left, index), right);
+		}
+
+		bool erase(const T& value)
+		{
+			const auto found = m_lookup.find(value);
+			if (found == m_lookup.end())
+			{
+				return false;
+			}
+
+			const u32 index = found->second;
+			m_lookup.erase(found);
+
+			unlink(index);
+			m_free_list.push_back(index);
+			return true;
+		}
+
+		void clear()
+		{
+			m_nodes.clear();
+			m_free_list.clear();
+			m_lookup.clear();
+			m_root = nil;
+		}
+
+		bool contains(const T& value) const
+		{
+			return m_lookup.contains(value);
+		}
+
+		usz size() const
+		{
+			return m_lookup.size();
+		}
+
+		bool empty() const
+		{
+			return m_lookup.empty();
+		}
+
+		// Calls func(value) for every entry overlapping range. Returning false from func stops the query
+		template <typename F>
+		void for_each_overlap(const address_range& range, F&& func) const
+		{
+			AUDIT(range.valid());
+			visit(m_root, range, func);
+		}
+
+		bool overlaps(const address_range& range) const
+		{
+			bool result = false;
+			for_each_overlap(range, [&](const T&)
+			{
+				result = true;
+				return false;
+			});
+
+			return result;
+		}
+	};
+}
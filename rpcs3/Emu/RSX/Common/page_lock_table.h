@@ -0,0 +1,273 @@
+#pragma once
+
+#include "../rsx_utils.h"
+#include "Utilities/mutex.h"
+#include "Emu/Memory/vm.h"
+#include "util/vm.hpp"
+
+#include <array>
+#include <vector>
+
+namespace rsx
+{
+	// Caches which write protect the guest memory they were built from
+	enum class page_lock_owner : u8
+	{
+		vertex_cache = 0,
+		index_cache,
+
+		count
+	};
+
+	/**
+	 * Arbitrates guest page protection between the texture cache and the caches keyed on guest memory contents.
+	 * The texture cache owns the requested protection of a page. Cache locks only ever add write protection on top of it,
+	 * so a page released by the texture cache stays read-only for as long as cached data built from it lives on.
+	 * Write faults on locked pages are consumed here and queued for the RSX thread to drop the affected ranges.
+	 */
+	class page_lock_table_t
+	{
+		static constexpr usz num_owners = static_cast<usz>(page_lock_owner::count);
+
+		struct per_page_info_t
+		{
+			u8 prot = 0;  // Protection requested by the texture cache
+			u8 locks = 0; // Bitmask of page_lock_owner write protecting the page
+
+			FORCE_INLINE utils::protection get_protection() const
+			{
+				if (locks && prot == static_cast<u8>(utils::protection::rw))
+				{
+					return utils::protection::ro;
+				}
+
+				return static_cast<utils::protection>(prot);
+			}
+		};
+
+		static_assert(static_cast<u32>(utils::protection::rw) == 0, "utils::protection::rw must have value 0 for the zero-initialized table to work");
+
+		// 4GB memory space / 4096 bytes per page = 1048576 pages
+		static constexpr usz num_pages = 0x1'0000'0000 / 4096;
+		per_page_info_t _info[num_pages]{};
+
+		shared_mutex m_mutex;
+		std::array<std::vector<address_range>, num_owners> m_invalidated_ranges;
+		atomic_t<u8> m_has_invalidated_ranges = 0;
+		atomic_t<u32> m_locked_pages = 0;
+
+		static constexpr u8 owner_bit(page_lock_owner owner)
+		{
+			return static_cast<u8>(1u << static_cast<u32>(owner));
+		}
+
+		static constexpr usz rsx_address_to_index(u32 address)
+		{
+			return (address / 4096);
+		}
+
+		static constexpr u32 index_to_rsx_address(usz idx)
+		{
+			return static_cast<u32>(idx * 4096);
+		}
+
+		// Apply the effective protection of a page range, coalescing runs of identical protection into a single call
+		void apply_protection(usz first, usz last)
+		{
+			usz run_start = first;
+			utils::protection run_prot = _info[first].get_protection();
+
+			for (usz idx = first + 1; idx <= last; idx++)
+			{
+				const utils::protection prot = _info[idx].get_protection();
+				if (prot == run_prot)
+				{
+					continue;
+				}
+
+				utils::memory_protect(vm::base(index_to_rsx_address(run_start)), (idx - run_start) * 4096, run_prot);
+				run_start = idx;
+				run_prot = prot;
+			}
+
+			utils::memory_protect(vm::base(index_to_rsx_address(run_start)), (last + 1 - run_start) * 4096, run_prot);
+		}
+
+		// NOTE: m_mutex must be held
+		void queue_invalidation(u8 locks, const address_range& range)
+		{
+			for (usz owner = 0; owner < num_owners; owner++)
+			{
+				if (locks & (1u << owner))
+				{
+					m_invalidated_ranges[owner].push_back(range);
+				}
+			}
+
+			m_has_invalidated_ranges |= locks;
+		}
+
+	public:
+		// Called by the texture cache whenever it changes the protection of its sections
+		void set_protection(const address_range& range, utils::protection prot)
+		{
+			AUDIT(range.is_page_range());
+
+			const usz first = rsx_address_to_index(range.start);
+			const usz last = rsx_address_to_index(range.end);
+
+			std::lock_guard lock(m_mutex);
+
+			for (usz idx = first; idx <= last; idx++)
+			{
+				_info[idx].prot = static_cast<u8>(prot);
+			}
+
+			if (!m_locked_pages)
+			{
+				// Fast path, nothing to arbitrate
+				utils::memory_protect(vm::base(range.start), range.length(), prot);
+				return;
+			}
+
+			apply_protection(first, last);
+		}
+
+		// Write protect the pages covering the range. Must be called before the data is read
+		void lock_range(page_lock_owner owner, const address_range& range)
+		{
+			AUDIT(range.is_page_range());
+
+			const usz first = rsx_address_to_index(range.start);
+			const usz last = rsx_address_to_index(range.end);
+
+			std::lock_guard lock(m_mutex);
+
+			const u8 bit = owner_bit(owner);
+
+			bool modified = false;
+			for (usz idx = first; idx <= last; idx++)
+			{
+				auto& info = _info[idx];
+				if (!(info.locks & bit))
+				{
+					if (!info.locks)
+					{
+						m_locked_pages++;
+						modified = true;
+					}
+
+					info.locks |= bit;
+				}
+			}
+
+			if (modified)
+			{
+				apply_protection(first, last);
+			}
+		}
+
+		void unlock_range(page_lock_owner owner, const address_range& range)
+		{
+			AUDIT(range.is_page_range());
+
+			const usz first = rsx_address_to_index(range.start);
+			const usz last = rsx_address_to_index(range.end);
+
+			std::lock_guard lock(m_mutex);
+
+			const u8 bit = owner_bit(owner);
+
+			bool modified = false;
+			for (usz idx = first; idx <= last; idx++)
+			{
+				auto& info = _info[idx];
+				if (info.locks & bit)
+				{
+					info.locks &= ~bit;
+
+					if (!info.locks)
+					{
+						m_locked_pages--;
+						modified = true;
+					}
+				}
+			}
+
+			if (modified)
+			{
+				apply_protection(first, last);
+			}
+		}
+
+		// Access violation hook. Returns true if the fault was caused by a cache lock
+		bool on_write_fault(u32 address)
+		{
+			if (!m_locked_pages)
+			{
+				return false;
+			}
+
+			const usz idx = rsx_address_to_index(address);
+
+			std::lock_guard lock(m_mutex);
+
+			const u8 locks = _info[idx].locks;
+			if (!locks)
+			{
+				return false;
+			}
+
+			_info[idx].locks = 0;
+			m_locked_pages--;
+			apply_protection(idx, idx);
+
+			queue_invalidation(locks, utils::page_for(address));
+			return true;
+		}
+
+		// Memory is being unmapped, forget about the range without touching the page protection
+		void on_unmap(const address_range& range)
+		{
+			const usz first = rsx_address_to_index(range.start);
+			const usz last = rsx_address_to_index(range.end);
+
+			std::lock_guard lock(m_mutex);
+
+			u8 locks = 0;
+			for (usz idx = first; idx <= last; idx++)
+			{
+				if (_info[idx].locks)
+				{
+					locks |= _info[idx].locks;
+					_info[idx].locks = 0;
+					m_locked_pages--;
+				}
+
+				_info[idx].prot = static_cast<u8>(utils::protection::rw);
+			}
+
+			if (locks)
+			{
+				queue_invalidation(locks, range.to_page_range());
+			}
+		}
+
+		bool has_invalidated_ranges(page_lock_owner owner) const
+		{
+			return !!(m_has_invalidated_ranges & owner_bit(owner));
+		}
+
+		std::vector<address_range> take_invalidated_ranges(page_lock_owner owner)
+		{
+			std::lock_guard lock(m_mutex);
+
+			std::vector<address_range> result;
+			result.swap(m_invalidated_ranges[static_cast<usz>(owner)]);
+			m_has_invalidated_ranges &= ~owner_bit(owner);
+			return result;
+		}
+	};
+
+	extern page_lock_table_t page_lock_table;
+}
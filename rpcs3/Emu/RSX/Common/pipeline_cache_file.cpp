@@ -0,0 +1,303 @@
+#include "stdafx.h"
+#include "pipeline_cache_file.h"
+
+#include "Emu/RSX/rsx_utils.h"
+
+namespace rsx
+{
+	bool pipeline_cache_file::open(const std::string& path, u32 pipeline_record_size)
+	{
+		close();
+
+		m_path = path;
+		m_pipeline_record_size = pipeline_record_size;
+
+		if (!m_file.open(m_path, fs::read + fs::write + fs::create))
+		{
+			rsx_log.error("Failed to open shader cache file '%s' (%s)", m_path, fs::g_tls_error);
+			return false;
+		}
+
+		if (!read_contents())
+		{
+			return create_new();
+		}
+
+		if (m_dead_bytes && (m_dead_bytes * 4) > m_file_size)
+		{
+			// More than a quarter of the file is garbage
+			if (!compact())
+			{
+				return false;
+			}
+		}
+
+		m_file.seek(0, fs::seek_end);
+		return true;
+	}
+
+	void pipeline_cache_file::close()
+	{
+		m_file.close();
+		m_contents = {};
+		m_pipeline_keys = {};
+		m_file_size = 0;
+		m_dead_bytes = 0;
+
+		for (auto& index : m_index)
+		{
+			index.clear();
+		}
+	}
+
+	bool pipeline_cache_file::create_new()
+	{
+		m_contents = {};
+		m_pipeline_keys = {};
+		m_dead_bytes = 0;
+
+		for (auto& index : m_index)
+		{
+			index.clear();
+		}
+
+		const file_header header{ file_magic, file_version, m_pipeline_record_size };
+
+		if (!m_file.trunc(0) || m_file.seek(0) != 0 || !m_file.write(header))
+		{
+			rsx_log.error("Failed to initialize shader cache file '%s'", m_path);
+			m_file.close();
+			return false;
+		}
+
+		m_file_size = sizeof(file_header);
+		return true;
+	}
+
+	bool pipeline_cache_file::read_contents()
+	{
+		// Read the whole file at once; the records are tiny and reading them one by one is what we are trying to avoid
+		m_file.seek(0);
+		m_contents = m_file.to_vector<u8>();
+		m_file_size = m_contents.size();
+
+		file_header header{};
+		if (m_file_size < sizeof(file_header))
+		{
+			return false;
+		}
+
+		std::memcpy(&header, m_contents.data(), sizeof(file_header));
+		if (header.magic != file_magic || header.version != file_version || header.pipeline_record_size != m_pipeline_record_size)
+		{
+			rsx_log.warning("Shader cache file '%s' is not compatible with this build and will be discarded", m_path);
+			return false;
+		}
+
+		u64 offset = sizeof(file_header);
+		while (offset + sizeof(record_header) <= m_file_size)
+		{
+			record_header record{};
+			std::memcpy(&record, m_contents.data() + offset, sizeof(record_header));
+
+			const u64 payload_offset = offset + sizeof(record_header);
+			if (record.type >= num_record_types || record.size > max_record_size || (payload_offset + record.size) > m_file_size)
+			{
+				// Torn write at the end of the file or garbage, nothing past this point can be trusted
+				break;
+			}
+
+			offset = payload_offset + record.size;
+
+			const auto type = static_cast<record_type>(record.type);
+			if (type == record_type::pipeline && record.size != m_pipeline_record_size)
+			{
+				m_dead_bytes += sizeof(record_header) + record.size;
+				continue;
+			}
+
+			if (!m_index[record.type].try_emplace(record.key, record_location{ payload_offset, record.size }).second)
+			{
+				// Duplicate entry, written by two emulator instances sharing the cache
+				m_dead_bytes += sizeof(record_header) + record.size;
+				continue;
+			}
+
+			if (type == record_type::pipeline)
+			{
+				m_pipeline_keys.push_back(record.key);
+			}
+		}
+
+		if (offset != m_file_size)
+		{
+			rsx_log.warning("Shader cache file '%s' has %llu bytes of trailing garbage, dropping it", m_path, m_file_size - offset);
+
+			// Cut the file back to the last good record so that new records can be appended
+			m_file.trunc(offset);
+			m_contents.resize(offset);
+			m_file_size = offset;
+		}
+
+		return true;
+	}
+
+	bool pipeline_cache_file::compact()
+	{
+		rsx_log.notice("Compacting shader cache file '%s' (%llu of %llu bytes are unused)", m_path, m_dead_bytes, m_file_size);
+
+		const std::string tmp_path = m_path + ".tmp";
+		fs::file tmp(tmp_path, fs::rewrite);
+
+		if (!tmp)
+		{
+			rsx_log.error("Failed to create '%s' (%s)", tmp_path, fs::g_tls_error);
+			return !!m_file;
+		}
+
+		const file_header header{ file_magic, file_version, m_pipeline_record_size };
+		tmp.write(header);
+
+		std::vector<u8> contents;
+		contents.reserve(m_file_size - m_dead_bytes);
+		contents.resize(sizeof(file_header));
+		std::memcpy(contents.data(), &header, sizeof(file_header));
+
+		// Record locations in the compacted file, only committed once it has replaced the old one
+		auto index = m_index;
+
+		// Programs first, then pipelines in their original order so that the load order does not change
+		for (usz type = 0; type < num_record_types; ++type)
+		{
+			auto emit = [&](u64 key, record_location& location)
+			{
+				const record_header record{ static_cast<u32>(type), location.size, key };
+				const u64 payload_offset = contents.size() + sizeof(record_header);
+
+				contents.resize(payload_offset + location.size);
+				std::memcpy(contents.data() + payload_offset - sizeof(record_header), &record, sizeof(record_header));
+				std::memcpy(contents.data() + payload_offset, m_contents.data() + location.offset, location.size);
+
+				location.offset = payload_offset;
+			};
+
+			if (static_cast<record_type>(type) == record_type::pipeline)
+			{
+				for (const u64 key : m_pipeline_keys)
+				{
+					emit(key, index[type].at(key));
+				}
+			}
+			else
+			{
+				for (auto& [key, location] : index[type])
+				{
+					emit(key, location);
+				}
+			}
+		}
+
+		if (tmp.write(contents.data() + sizeof(file_header), contents.size() - sizeof(file_header)) != contents.size() - sizeof(file_header))
+		{
+			rsx_log.error("Failed to write '%s' (%s)", tmp_path, fs::g_tls_error);
+			tmp.close();
+			fs::remove_file(tmp_path);
+			return true;
+		}
+
+		tmp.close();
+		m_file.close();
+
+		if (!fs::rename(tmp_path, m_path, true))
+		{
+			rsx_log.error("Failed to replace shader cache file '%s' (%s)", m_path, fs::g_tls_error);
+			fs::remove_file(tmp_path);
+		}
+		else
+		{
+			m_contents = std::move(contents);
+			m_index = std::move(index);
+			m_file_size = m_contents.size();
+			m_dead_bytes = 0;
+		}
+
+		if (!m_file.open(m_path, fs::read + fs::write + fs::create))
+		{
+			rsx_log.error("Failed to reopen shader cache file '%s' (%s)", m_path, fs::g_tls_error);
+			return false;
+		}
+
+		return true;
+	}
+
+	bool pipeline_cache_file::append(record_type type, u64 key, const void* data, u32 size)
+	{
+		ensure(size <= max_record_size);
+
+		std::lock_guard lock(m_mutex);
+
+		if (!m_file)
+		{
+			return false;
+		}
+
+		auto& index = m_index[static_cast<usz>(type)];
+		if (!index.try_emplace(key, record_location{ m_file_size + sizeof(record_header), size }).second)
+		{
+			return false;
+		}
+
+		const record_header record{ static_cast<u32>(type), size, key };
+
+		const fs::iovec_clone gather[2]
+		{
+			{ &record, sizeof(record) },
+			{ data, size }
+		};
+
+		if (m_file.write_gather(gather, 2) != sizeof(record) + size)
+		{
+			rsx_log.error("Failed to write to shader cache file '%s' (%s)", m_path, fs::g_tls_error);
+
+			// Do not leave a torn record behind, it would hide everything appended after it
+			m_file.trunc(m_file_size);
+			m_file.seek(0, fs::seek_end);
+			index.erase(key);
+			return false;
+		}
+
+		m_file_size += sizeof(record) + size;
+		return true;
+	}
+
+	bool pipeline_cache_file::contains(record_type type, u64 key)
+	{
+		reader_lock lock(m_mutex);
+		return m_index[static_cast<usz>(type)].contains(key);
+	}
+
+	std::span<const u8> pipeline_cache_file::find(record_type type, u64 key) const
+	{
+		reader_lock lock(m_mutex);
+
+		const auto& index = m_index[static_cast<usz>(type)];
+
+		if (const auto found = index.find(key); found != index.end())
+		{
+			const auto& location = found->second;
+			if (location.offset + location.size <= m_contents.size())
+			{
+				return { m_contents.data() + location.offset, location.size };
+			}
+		}
+
+		return {};
+	}
+
+	void pipeline_cache_file::release_contents()
+	{
+		std::lock_guard lock(m_mutex);
+		m_contents = {};
+		m_pipeline_keys = {};
+	}
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "Utilities/File.h"
+#include "Utilities/mutex.h"
+
+#include <array>
+#include <span>
+#include <unordered_map>
+
+namespace rsx
+{
+	/**
+	 * Packed single file storage for the shader cache.
+	 * Records are only ever appended, each one is tagged with a type and a 64-bit key and is stored at most once per key.
+	 * The whole file is read in a single pass on open and indexed in memory, replacing the per-pipeline file layout
+	 * that made cold boots spend most of their time in filesystem metadata.
+	 * Dead records (duplicates, invalid entries) are dropped by a compaction pass when they take up too much space.
+	 */
+	class pipeline_cache_file
+	{
+	public:
+		enum class record_type : u32
+		{
+			vertex_program = 0,
+			fragment_program,
+			pipeline,
+
+			count
+		};
+
+		// Sanity limit on a single record, anything bigger is treated as corruption
+		static constexpr u32 max_record_size = 0x100000;
+
+	private:
+		static constexpr u64 file_magic = "RSXPPACK"_u64;
+		static constexpr u32 file_version = 1;
+
+		struct file_header
+		{
+			u64 magic;
+			u32 version;
+			u32 pipeline_record_size; // Records are not portable across pipeline layouts
+		};
+
+		struct record_header
+		{
+			u32 type;
+			u32 size;
+			u64 key;
+		};
+
+		struct record_location
+		{
+			u64 offset; // Payload offset in the file
+			u32 size;
+		};
+
+		static constexpr usz num_record_types = static_cast<usz>(record_type::count);
+
+		std::string m_path;
+		u32 m_pipeline_record_size = 0;
+
+		fs::file m_file;
+		mutable shared_mutex m_mutex;
+
+		// File contents as read on open. Released with release_contents once loading is done
+		std::vector<u8> m_contents;
+		std::array<std::unordered_map<u64, record_location>, num_record_types> m_index;
+		std::vector<u64> m_pipeline_keys; // Pipeline records in file order
+
+		u64 m_file_size = 0;
+		u64 m_dead_bytes = 0;
+
+		bool create_new();
+		bool read_contents();
+		bool compact();
+
+	public:
+		pipeline_cache_file() = default;
+
+		pipeline_cache_file(const pipeline_cache_file&) = delete;
+		pipeline_cache_file& operator=(const pipeline_cache_file&) = delete;
+
+		// Open or create the cache file. Files written with a different pipeline layout are discarded
+		bool open(const std::string& path, u32 pipeline_record_size);
+		void close();
+
+		explicit operator bool() const
+		{
+			return !!m_file;
+		}
+
+		// Returns false if the key is already present or the write failed
+		bool append(record_type type, u64 key, const void* data, u32 size);
+		bool contains(record_type type, u64 key);
+
+		// Lookups into the contents read on open. Safe to call concurrently
+		std::span<const u8> find(record_type type, u64 key) const;
+		const std::vector<u64>& get_pipeline_keys() const { return m_pipeline_keys; }
+
+		// Frees the memory held by the file contents, lookups return nothing afterwards
+		void release_contents();
+	};
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "surface_utils.h"
+#include "interval_tree.h"
 #include "../gcm_enums.h"
 #include "../rsx_utils.h"
 #include <list>
@@ -18,6 +19,78 @@ namespace rsx
 		usz get_packed_pitch(surface_color_format format, u32 width);
 	}
 
+	/**
+	 * Surfaces keyed on their base address, with an index over their memory ranges for overlap queries.
+	 * Stored surfaces may only have their memory range changed through update() to keep the index in sync.
+	 */
+	template <typename Traits>
+	class surface_ranged_map
+	{
+	public:
+		using surface_storage_type = typename Traits::surface_storage_type;
+		using container_type = std::unordered_map<u32, surface_storage_type>;
+		using iterator = typename container_type::iterator;
+
+	private:
+		container_type m_data;
+		interval_tree<u32> m_index;
+
+		void refresh(u32 address)
+		{
+			const auto& storage = m_data.at(address);
+			m_index.insert(Traits::get(storage)->get_memory_range(), address);
+		}
+
+	public:
+		iterator begin() { return m_data.begin(); }
+		iterator end() { return m_data.end(); }
+		iterator find(u32 address) { return m_data.find(address); }
+		bool empty() const { return m_data.empty(); }
+
+		// Replaces any surface already stored at address
+		void emplace(u32 address, surface_storage_type&& storage)
+		{
+			m_data[address] = std::move(storage);
+			refresh(address);
+		}
+
+		// Calls func(storage) on the surface stored at address and reindexes it, for changes to its pitch or size
+		template <typename F>
+		void update(u32 address, F&& func)
+		{
+			func(m_data.at(address));
+			refresh(address);
+		}
+
+		iterator erase(iterator it)
+		{
+			m_index.erase(it->first);
+			return m_data.erase(it);
+		}
+
+		void erase(u32 address)
+		{
+			m_index.erase(address);
+			m_data.erase(address);
+		}
+
+		void clear()
+		{
+			m_index.clear();
+			m_data.clear();
+		}
+
+		// Calls func(address, storage) for every stored surface overlapping range, in ascending address order
+		template <typename F>
+		void for_each_overlap(const rsx::address_range& range, F&& func)
+		{
+			m_index.for_each_overlap(range, [&](u32 address)
+			{
+				func(address, m_data.at(address));
+			});
+		}
+	};
+
 	template<typename Traits>
 	struct surface_store
 	{
@@ -43,10 +116,11 @@ namespace rsx
 		using surface_type = typename Traits::surface_type;
 		using command_list_type = typename Traits::command_list_type;
 		using surface_overlap_info = surface_overlap_info_t<surface_type>;
+		using surface_ranged_map_type = surface_ranged_map<Traits>;
 
 	protected:
-		std::unordered_map<u32, surface_storage_type> m_render_targets_storage = {};
-		std::unordered_map<u32, surface_storage_type> m_depth_stencil_storage = {};
+		surface_ranged_map_type m_render_targets_storage = {};
+		surface_ranged_map_type m_depth_stencil_storage = {};
 
 		rsx::address_range m_render_targets_memory_range;
 		rsx::address_range m_depth_stencil_memory_range;
@@ -86,7 +160,7 @@ namespace rsx
 			auto insert_new_surface = [&](
 				u32 new_address,
 				deferred_clipped_region<surface_type>& region,
-				std::unordered_map<u32, surface_storage_type>& data)
+				surface_ranged_map_type& data)
 			{
 				surface_storage_type sink;
 				surface_type invalidated = 0;
@@ -152,7 +226,7 @@ namespace rsx
 
 				ensure(region.target == Traits::get(sink));
 				orphaned_surfaces.push_back(region.target);
-				data[new_address] = std::move(sink);
+				data.emplace(new_address, std::move(sink));
 			};
 
 			// Define incoming region
@@ -240,47 +314,42 @@ namespace rsx
 		void intersect_surface_region(command_list_type cmd, u32 address, surface_type new_surface, surface_type prev_surface)
 		{
 			auto scan_list = [&new_surface, address](const rsx::address_range& mem_range,
-				std::unordered_map<u32, surface_storage_type>& data) -> std::vector<std::pair<u32, surface_type>>
+				surface_ranged_map_type& data) -> std::vector<std::pair<u32, surface_type>>
 			{
 				std::vector<std::pair<u32, surface_type>> result;
-				for (const auto &e : data)
+				data.for_each_overlap(mem_range, [&](u32 this_address, surface_storage_type& storage)
 				{
-					auto surface = Traits::get(e.second);
+					auto surface = Traits::get(storage);
 
 					if (new_surface->last_use_tag >= surface->last_use_tag ||
 						new_surface == surface ||
-						address == e.first)
+						address == this_address)
 					{
 						// Do not bother synchronizing with uninitialized data
-						continue;
+						return;
 					}
 
 					// Memory partition check
 					if (mem_range.start >= constants::local_mem_base)
 					{
-						if (e.first < constants::local_mem_base) continue;
+						if (this_address < constants::local_mem_base) return;
 					}
 					else
 					{
-						if (e.first >= constants::local_mem_base) continue;
+						if (this_address >= constants::local_mem_base) return;
 					}
 
 					// Pitch check
 					if (!rsx::pitch_compatible(surface, new_surface))
 					{
-						continue;
+						return;
 					}
 
-					// Range check
-					const rsx::address_range this_range = surface->get_memory_range();
-					if (!this_range.overlaps(mem_range))
-					{
-						continue;
-					}
+					AUDIT(surface->get_memory_range().overlaps(mem_range));
 
-					result.push_back({ e.first, surface });
-					ensure(e.first == surface->base_addr);
-				}
+					result.push_back({ this_address, surface });
+					ensure(this_address == surface->base_addr);
+				});
 
 				return result;
 			};
@@ -369,17 +438,17 @@ namespace rsx
 				{
 					// This has been 'swallowed' by the new surface and can be safely freed
 					auto &storage = surface->is_depth_surface() ? m_depth_stencil_storage : m_render_targets_storage;
-					auto &object = storage[e.first];
+					auto found = storage.find(e.first);
 
-					ensure(object);
+					ensure(found != storage.end() && found->second);
 
 					if (!surface->old_contents.empty()) [[unlikely]]
 					{
 						surface->read_barrier(cmd);
 					}
 
-					invalidate(object);
-					storage.erase(e.first);
+					invalidate(found->second);
+					storage.erase(found);
 					superseded_surfaces.push_back(surface);
 				}
 			}
@@ -403,7 +472,7 @@ namespace rsx
 			bool store = true;
 
 			address_range *storage_bounds;
-			std::unordered_map<u32, surface_storage_type> *primary_storage, *secondary_storage;
+			surface_ranged_map_type *primary_storage, *secondary_storage;
 			if constexpr (depth)
 			{
 				primary_storage = &m_depth_stencil_storage;
@@ -427,9 +496,17 @@ namespace rsx
 				if (Traits::surface_matches_properties(surface, format, width, height, antialias))
 				{
 					if (pitch_compatible)
+					{
 						Traits::notify_surface_persist(surface);
+					}
 					else
-						Traits::invalidate_surface_contents(command_list, Traits::get(surface), address, pitch);
+					{
+						// The memory range follows the pitch
+						primary_storage->update(address, [&](surface_storage_type& stored)
+						{
+							Traits::invalidate_surface_contents(command_list, Traits::get(stored), address, pitch);
+						});
+					}
 
 					Traits::prepare_surface_for_drawing(command_list, Traits::get(surface));
 					new_surface = Traits::get(surface);
@@ -554,7 +631,7 @@ namespace rsx
 			if (store)
 			{
 				// New surface was found among invalidated surfaces or created from scratch
-				(*primary_storage)[address] = std::move(new_surface_storage);
+				primary_storage->emplace(address, std::move(new_surface_storage));
 			}
 
 			ensure(!old_surface_storage);
@@ -789,23 +866,20 @@ namespace rsx
 
 			const auto test_range = utils::address_range::start_length(texaddr, (required_pitch * required_height) - (required_pitch - surface_internal_pitch));
 
-			auto process_list_function = [&](std::unordered_map<u32, surface_storage_type>& data, bool is_depth)
+			auto process_list_function = [&](surface_ranged_map_type& data, bool is_depth)
 			{
-				for (auto& tex_info : data)
+				data.for_each_overlap(test_range, [&](u32, surface_storage_type& storage)
 				{
-					const auto range = tex_info.second->get_memory_range();
-					if (!range.overlaps(test_range))
-						continue;
-
-					auto surface = tex_info.second.get();
+					const auto range = storage->get_memory_range();
+					auto surface = storage.get();
 					if (access.is_transfer() && access.is_read() && surface->write_through())
 					{
 						// The surface has no data other than what can be loaded from CPU
-						continue;
+						return;
 					}
 
 					if (!rsx::pitch_compatible(surface, required_pitch, required_height))
-						continue;
+						return;
 
 					surface_overlap_info info;
 					u32 width, height;
@@ -825,7 +899,7 @@ namespace rsx
 						if (info.dst_area.x >= required_width || info.dst_area.y >= required_height) [[unlikely]]
 						{
 							// Out of bounds
-							continue;
+							return;
 						}
 
 						info.src_area.x = 0;
@@ -844,7 +918,7 @@ namespace rsx
 						{
 							// Region lies outside the actual texture area, but inside the 'tile'
 							// In this case, a small region lies to the top-left corner, partially occupying the  target
-							continue;
+							return;
 						}
 
 						info.dst_area.x = 0;
@@ -857,7 +931,7 @@ namespace rsx
 					if (surface->memory_barrier(cmd, access); !surface->test())
 					{
 						dirty.emplace_back(range.start, is_depth);
-						continue;
+						return;
 					}
 
 					info.is_clipped = (width < required_width || height < required_height);
@@ -876,7 +950,7 @@ namespace rsx
 					}
 
 					result.push_back(info);
-				}
+				});
 			};
 
 			// Range test helper to quickly discard blocks
@@ -1050,23 +1124,14 @@ namespace rsx
 
 		void invalidate_range(const rsx::address_range& range)
 		{
-			for (auto &rtt : m_render_targets_storage)
+			auto process_list_function = [](u32, surface_storage_type& storage)
 			{
-				if (range.overlaps(rtt.second->get_memory_range()))
-				{
-					rtt.second->clear_rw_barrier();
-					rtt.second->state_flags |= rsx::surface_state_flags::erase_bkgnd;
-				}
-			}
+				storage->clear_rw_barrier();
+				storage->state_flags |= rsx::surface_state_flags::erase_bkgnd;
+			};
 
-			for (auto &ds : m_depth_stencil_storage)
-			{
-				if (range.overlaps(ds.second->get_memory_range()))
-				{
-					ds.second->clear_rw_barrier();
-					ds.second->state_flags |= rsx::surface_state_flags::erase_bkgnd;
-				}
-			}
+			m_render_targets_storage.for_each_overlap(range, process_list_function);
+			m_depth_stencil_storage.for_each_overlap(range, process_list_function);
 		}
 
 		bool check_memory_usage(u64 max_safe_memory) const
@@ -1084,7 +1149,7 @@ namespace rsx
 
 		bool handle_memory_pressure(command_list_type cmd, problem_severity /*severity*/)
 		{
-			auto process_list_function = [&](std::unordered_map<u32, surface_storage_type>& data)
+			auto process_list_function = [&](surface_ranged_map_type& data)
 			{
 				for (auto It = data.begin(); It != data.end();)
 				{
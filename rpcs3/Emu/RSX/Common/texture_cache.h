@@ -3,6 +3,7 @@
 #include "texture_cache_utils.h"
 #include "texture_cache_predictor.h"
 #include "texture_cache_helpers.h"
+#include "texture_cache_stats.h"
 
 #include <unordered_map>
 
@@ -337,6 +338,22 @@ namespace rsx
 		atomic_t<u32> m_unavoidable_hard_faults_this_frame = { 0 };
 		atomic_t<u32> m_texture_upload_calls_this_frame = { 0 };
 		atomic_t<u32> m_texture_upload_misses_this_frame = { 0 };
+		atomic_t<u64> m_texture_upload_bytes_this_frame = { 0 };
+		atomic_t<u64> m_flush_bytes_this_frame = { 0 };
+		atomic_t<u32> m_invalidations_this_frame = { 0 };
+		atomic_t<u32> m_blits_this_frame = { 0 };
+
+		// Time spent in each path in ns. Only measured while someone consumes the statistics
+		bool m_collect_statistics = false;
+		atomic_t<u64> m_lookup_time_this_frame = { 0 };
+		atomic_t<u64> m_upload_time_this_frame = { 0 };
+		atomic_t<u64> m_blit_time_this_frame = { 0 };
+		atomic_t<u64> m_invalidate_time_this_frame = { 0 };
+		atomic_t<u64> m_flush_time_this_frame = { 0 };
+
+		u64 m_frame_index = 0;
+		texture_cache_frame_statistics m_last_frame_statistics{};
+		texture_cache_stats_log m_stats_log;
 		static const u32 m_predict_max_flushes_per_frame = 50; // Above this number the predictions are disabled
 
 		// Invalidation
@@ -435,7 +452,7 @@ namespace rsx
 
 			// Check that there is at least one valid (locked) section in the test_range
 			reader_lock lock(m_cache_mutex);
-			if (m_storage.range_begin(test_range, locked_range, true) == m_storage.range_end())
+			if (!m_storage.overlaps(test_range, locked_range, true))
 				return false;
 
 			// We do intersect the cache
@@ -451,6 +468,8 @@ namespace rsx
 		{
 			AUDIT(!data.flushed);
 
+			texture_cache_stats_timer timer(m_flush_time_this_frame, m_collect_statistics);
+
 			if (data.sections_to_flush.size() > 1)
 			{
 				// Sort with oldest data first
@@ -698,25 +717,29 @@ namespace rsx
 			invalidate_range = fault_range; // Sections fully inside this range will be invalidated, others will be deemed false positives
 
 			// Loop through cache and find pages that overlap the invalidate_range
-			u32 last_dirty_block = -1;
-			bool repeat_loop = false;
+			std::vector<section_storage_type*> candidates;
+			bool repeat_loop = true;
 
-			auto It = m_storage.range_begin(invalidate_range, locked_range, true); // will iterate through locked sections only
-			while (It != m_storage.range_end())
+			while (repeat_loop)
 			{
-				const u32 base = It.get_block().get_start();
+				repeat_loop = false;
 
-				// On the last loop, we stop once we're done with the last dirty block
-				if (!repeat_loop && base > last_dirty_block) // note: blocks are iterated in order from lowest to highest base address
-					break;
+				// Gather first, the ranges are extended while the candidates are processed
+				candidates.clear();
+				m_storage.for_each_overlap(invalidate_range, locked_range, true, [&](section_storage_type& tex) // locked sections only
+				{
+					if (tex.cache_tag != cache_tag) //flushable sections can be 'clean' but unlocked. TODO: Handle this better
+					{
+						candidates.push_back(&tex);
+					}
+				});
 
-				auto &tex = *It;
+				for (auto* candidate : candidates)
+				{
+					auto &tex = *candidate;
 
-				AUDIT(tex.is_locked()); // we should be iterating locked sections only, but just to make sure...
-				AUDIT(tex.cache_tag != cache_tag || last_dirty_block != umax); // cache tag should not match during the first loop
+					AUDIT(tex.is_locked()); // we should be iterating locked sections only, but just to make sure...
 
-				if (tex.cache_tag != cache_tag) //flushable sections can be 'clean' but unlocked. TODO: Handle this better
-				{
 					const rsx::section_bounds bounds = tex.get_overlap_test_bounds();
 
 					if (locked_range == bounds || tex.overlaps(invalidate_range, bounds))
@@ -730,12 +753,8 @@ namespace rsx
 						// Extend the various ranges
 						if (extend_invalidate_range && new_range != invalidate_range)
 						{
-							if (new_range.end > invalidate_range.end)
-								It.set_end(new_range.end);
-
 							invalidate_range = new_range;
-							repeat_loop = true; // we will need to repeat the loop again
-							last_dirty_block = base; // stop the repeat loop once we finish this block
+							repeat_loop = true; // sections overlapping the extension still need to be picked up
 						}
 
 						// Add texture to result, and update its cache tag
@@ -748,16 +767,6 @@ namespace rsx
 						}
 					}
 				}
-
-				// Iterate
-				It++;
-
-				// repeat_loop==true means some blocks are still dirty and we need to repeat the loop again
-				if (repeat_loop && It == m_storage.range_end())
-				{
-					It = m_storage.range_begin(invalidate_range, locked_range, true);
-					repeat_loop = false;
-				}
 			}
 
 			AUDIT(result.invalidate_range.is_page_range());
@@ -792,6 +801,9 @@ namespace rsx
 			AUDIT(fault_range_in.valid());
 			address_range fault_range = fault_range_in.to_page_range();
 
+			m_invalidations_this_frame++;
+			texture_cache_stats_timer timer(m_invalidate_time_this_frame, m_collect_statistics);
+
 			intersecting_set trampled_set = std::move(get_intersecting_set(fault_range));
 
 			thrashed_set result = {};
@@ -1009,9 +1021,16 @@ namespace rsx
 
 		virtual void on_frame_end()
 		{
+			// Snapshot before the predictor drops its counters
+			m_last_frame_statistics = get_frame_statistics();
+			m_stats_log.write(m_last_frame_statistics);
+
 			m_temporary_subresource_cache.clear();
 			m_predictor.on_frame_end();
 			reset_frame_statistics();
+
+			m_collect_statistics = texture_cache_stats_log::is_enabled() ||
+				(g_cfg.video.perf_overlay.perf_overlay_enabled && g_cfg.video.perf_overlay.texture_cache_stats);
 		}
 
 		template <bool check_unlocked = false>
@@ -1019,9 +1038,16 @@ namespace rsx
 		{
 			std::vector<section_storage_type*> results;
 
-			for (auto It = m_storage.range_begin(test_range, full_range, check_unlocked); It != m_storage.range_end(); It++)
+			// sync_protection can discard sections, which is not allowed while the index is being walked
+			m_storage.for_each_overlap(test_range, full_range, check_unlocked, [&](section_storage_type& tex)
+			{
+				results.push_back(&tex);
+			});
+
+			usz kept = 0;
+			for (auto* section : results)
 			{
-				auto &tex = *It;
+				auto &tex = *section;
 
 				if (!tex.is_dirty() && (context_mask & static_cast<u32>(tex.get_context())))
 				{
@@ -1035,10 +1061,11 @@ namespace rsx
 						continue;
 					}
 
-					results.push_back(&tex);
+					results[kept++] = &tex;
 				}
 			}
 
+			results.resize(kept);
 			return results;
 		}
 
@@ -1927,6 +1954,7 @@ namespace rsx
 		sampled_image_descriptor upload_texture(commandbuffer_type& cmd, const RsxTextureType& tex, surface_store_type& m_rtts, Args&&... extras)
 		{
 			m_texture_upload_calls_this_frame++;
+			texture_cache_stats_timer timer(m_lookup_time_this_frame, m_collect_statistics);
 
 			image_section_attributes_t attributes{};
 			texture_cache_search_options options{};
@@ -2140,6 +2168,9 @@ namespace rsx
 			const address_range tex_range = address_range::start_length(attributes.address, tex_size);
 			invalidate_range_impl_base(cmd, tex_range, invalidation_cause::read, std::forward<Args>(extras)...);
 
+			m_texture_upload_bytes_this_frame += tex_size;
+			texture_cache_stats_timer upload_timer(m_upload_time_this_frame, m_collect_statistics);
+
 			// Upload from CPU. Note that sRGB conversion is handled in the FS
 			auto uploaded = upload_image_from_cpu(cmd, tex_range, attributes.width, attributes.height, attributes.depth, tex.get_exact_mipmap_count(), attributes.pitch, attributes.gcm_format,
 				texture_upload_context::shader_read, subresources_layout, extended_dimension, attributes.swizzled);
@@ -2151,6 +2182,9 @@ namespace rsx
 		template <typename surface_store_type, typename blitter_type, typename ...Args>
 		blit_op_result upload_scaled_image(rsx::blit_src_info& src, rsx::blit_dst_info& dst, bool interpolate, commandbuffer_type& cmd, surface_store_type& m_rtts, blitter_type& blitter, Args&&... extras)
 		{
+			m_blits_this_frame++;
+			texture_cache_stats_timer timer(m_blit_time_this_frame, m_collect_statistics);
+
 			// Since we will have dst in vram, we can 'safely' ignore the swizzle flag
 			// TODO: Verify correct behavior
 			bool src_is_render_target = false;
@@ -3074,11 +3108,52 @@ namespace rsx
 			m_unavoidable_hard_faults_this_frame.store(0u);
 			m_texture_upload_calls_this_frame.store(0u);
 			m_texture_upload_misses_this_frame.store(0u);
+			m_texture_upload_bytes_this_frame.store(0u);
+			m_flush_bytes_this_frame.store(0u);
+			m_invalidations_this_frame.store(0u);
+			m_blits_this_frame.store(0u);
+			m_lookup_time_this_frame.store(0u);
+			m_upload_time_this_frame.store(0u);
+			m_blit_time_this_frame.store(0u);
+			m_invalidate_time_this_frame.store(0u);
+			m_flush_time_this_frame.store(0u);
+			m_frame_index++;
+		}
+
+		texture_cache_frame_statistics get_frame_statistics() const
+		{
+			texture_cache_frame_statistics result{};
+			result.frame = m_frame_index;
+			result.lookups = m_texture_upload_calls_this_frame;
+			result.uploads = m_texture_upload_misses_this_frame;
+			result.hits = result.lookups - std::min(result.lookups, result.uploads);
+			result.upload_bytes = m_texture_upload_bytes_this_frame;
+			result.invalidations = m_invalidations_this_frame;
+			result.flushes = m_flushes_this_frame;
+			result.flush_bytes = m_flush_bytes_this_frame;
+			result.hard_faults = m_misses_this_frame;
+			result.unavoidable_hard_faults = m_unavoidable_hard_faults_this_frame;
+			result.speculative_readbacks = m_speculations_this_frame;
+			result.mispredictions = m_predictor.m_mispredictions_this_frame;
+			result.blits = m_blits_this_frame;
+			result.lookup_time = m_lookup_time_this_frame / 1000;
+			result.upload_time = m_upload_time_this_frame / 1000;
+			result.blit_time = m_blit_time_this_frame / 1000;
+			result.invalidate_time = m_invalidate_time_this_frame / 1000;
+			result.flush_time = m_flush_time_this_frame / 1000;
+			return result;
+		}
+
+		// Statistics of the last complete frame
+		const texture_cache_frame_statistics& get_last_frame_statistics() const
+		{
+			return m_last_frame_statistics;
 		}
 
-		void on_flush()
+		void on_flush(const section_storage_type& section)
 		{
 			m_flushes_this_frame++;
+			m_flush_bytes_this_frame += section.get_confirmed_range().length();
 		}
 
 		void on_speculative_flush()
@@ -0,0 +1,82 @@
+#include "stdafx.h"
+#include "texture_cache_stats.h"
+
+#include "Emu/system_config.h"
+#include "Emu/RSX/rsx_utils.h"
+
+namespace rsx
+{
+	bool texture_cache_stats_log::is_enabled()
+	{
+		return g_cfg.video.texture_cache_stats_log != stats_log_format::disabled;
+	}
+
+	void texture_cache_stats_log::close()
+	{
+		m_file.close();
+	}
+
+	void texture_cache_stats_log::write(const texture_cache_frame_statistics& stats)
+	{
+		const stats_log_format format = g_cfg.video.texture_cache_stats_log;
+
+		if (format != m_format)
+		{
+			// Dynamic setting, start a new file whenever the format changes
+			close();
+			m_format = format;
+			m_open_failed = false;
+		}
+
+		if (format == stats_log_format::disabled || m_open_failed)
+		{
+			return;
+		}
+
+		if (!m_file)
+		{
+			const std::string path = fs::get_cache_dir() + (format == stats_log_format::csv ? "texture_cache_stats.csv" : "texture_cache_stats.jsonl");
+
+			if (!m_file.open(path, fs::rewrite))
+			{
+				rsx_log.error("Failed to create texture cache statistics log '%s' (%s)", path, fs::g_tls_error);
+				m_open_failed = true;
+				return;
+			}
+
+			rsx_log.notice("Logging texture cache statistics to '%s'", path);
+
+			if (format == stats_log_format::csv)
+			{
+				constexpr std::string_view header = "frame,lookups,hits,uploads,upload_bytes,invalidations,flushes,flush_bytes,hard_faults,unavoidable_hard_faults,"
+					"speculative_readbacks,mispredictions,readback_hit_ratio,predictor_accuracy,blits,"
+					"lookup_time_us,upload_time_us,blit_time_us,invalidate_time_us,flush_time_us\n";
+				m_file.write(header.data(), header.size());
+			}
+		}
+
+		std::string line;
+
+		if (format == stats_log_format::csv)
+		{
+			line = fmt::format("%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%.3f,%.3f,%u,%u,%u,%u,%u,%u\n",
+				stats.frame, stats.lookups, stats.hits, stats.uploads, stats.upload_bytes,
+				stats.invalidations, stats.flushes, stats.flush_bytes, stats.hard_faults, stats.unavoidable_hard_faults,
+				stats.speculative_readbacks, stats.mispredictions, stats.get_readback_hit_ratio(), stats.get_predictor_accuracy(), stats.blits,
+				stats.lookup_time, stats.upload_time, stats.blit_time, stats.invalidate_time, stats.flush_time);
+		}
+		else
+		{
+			line = fmt::format("{\"frame\":%u,\"lookups\":%u,\"hits\":%u,\"uploads\":%u,\"upload_bytes\":%u,"
+				"\"invalidations\":%u,\"flushes\":%u,\"flush_bytes\":%u,\"hard_faults\":%u,\"unavoidable_hard_faults\":%u,"
+				"\"speculative_readbacks\":%u,\"mispredictions\":%u,\"readback_hit_ratio\":%.3f,\"predictor_accuracy\":%.3f,\"blits\":%u,"
+				"\"lookup_time_us\":%u,\"upload_time_us\":%u,\"blit_time_us\":%u,\"invalidate_time_us\":%u,\"flush_time_us\":%u}\n",
+				stats.frame, stats.lookups, stats.hits, stats.uploads, stats.upload_bytes,
+				stats.invalidations, stats.flushes, stats.flush_bytes, stats.hard_faults, stats.unavoidable_hard_faults,
+				stats.speculative_readbacks, stats.mispredictions, stats.get_readback_hit_ratio(), stats.get_predictor_accuracy(), stats.blits,
+				stats.lookup_time, stats.upload_time, stats.blit_time, stats.invalidate_time, stats.flush_time);
+		}
+
+		m_file.write(line.data(), line.size());
+	}
+}
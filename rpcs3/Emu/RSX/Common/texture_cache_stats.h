@@ -0,0 +1,101 @@
+#pragma once
+
+#include "Utilities/File.h"
+#include "util/atomic.hpp"
+
+#include <chrono>
+
+enum class stats_log_format;
+
+namespace rsx
+{
+	/**
+	 * Texture cache activity over one frame.
+	 * Times are in microseconds. The timed paths nest, e.g. a lookup that falls back to a CPU upload also counts
+	 * the upload time and the time spent invalidating the uploaded range.
+	 */
+	struct texture_cache_frame_statistics
+	{
+		u64 frame = 0;
+
+		// Sampler lookups
+		u32 lookups = 0;
+		u32 hits = 0;                    // Served from cached sections or render targets
+		u32 uploads = 0;                 // Uploaded from CPU memory
+		u64 upload_bytes = 0;
+
+		// Memory faults
+		u32 invalidations = 0;
+		u32 flushes = 0;                 // Sections written back to guest memory
+		u64 flush_bytes = 0;
+		u32 hard_faults = 0;             // Flushes that had to wait for the GPU
+		u32 unavoidable_hard_faults = 0;
+		u32 speculative_readbacks = 0;   // Readbacks started ahead of a fault on the predictor's advice
+		u32 mispredictions = 0;          // Speculative readbacks made useless by a later write
+
+		// Blit engine
+		u32 blits = 0;
+
+		// Times are only collected while statistics are consumed
+		u64 lookup_time = 0;
+		u64 upload_time = 0;
+		u64 blit_time = 0;
+		u64 invalidate_time = 0;
+		u64 flush_time = 0;
+
+		// Fraction of the flushes which found their data already read back
+		f32 get_readback_hit_ratio() const
+		{
+			return flushes ? 1.f - std::min<f32>(1.f, static_cast<f32>(hard_faults) / flushes) : 1.f;
+		}
+
+		// Fraction of the speculative readbacks which were not invalidated before use
+		f32 get_predictor_accuracy() const
+		{
+			return speculative_readbacks ? 1.f - std::min<f32>(1.f, static_cast<f32>(mispredictions) / speculative_readbacks) : 1.f;
+		}
+	};
+
+	// Adds its lifetime in nanoseconds to a counter, does nothing when constructed disabled
+	class texture_cache_stats_timer
+	{
+		atomic_t<u64>* m_counter = nullptr;
+		std::chrono::steady_clock::time_point m_start;
+
+	public:
+		texture_cache_stats_timer(atomic_t<u64>& counter, bool enabled)
+		{
+			if (enabled) [[unlikely]]
+			{
+				m_counter = &counter;
+				m_start = std::chrono::steady_clock::now();
+			}
+		}
+
+		texture_cache_stats_timer(const texture_cache_stats_timer&) = delete;
+		texture_cache_stats_timer& operator=(const texture_cache_stats_timer&) = delete;
+
+		~texture_cache_stats_timer()
+		{
+			if (m_counter) [[unlikely]]
+			{
+				*m_counter += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count();
+			}
+		}
+	};
+
+	// Appends one record per frame to a CSV or JSON lines file in the cache directory
+	class texture_cache_stats_log
+	{
+		fs::file m_file;
+		stats_log_format m_format{};
+		bool m_open_failed = false;
+
+	public:
+		// Follows the configured format, opening or closing the file as needed
+		void write(const texture_cache_frame_statistics& stats);
+		void close();
+
+		static bool is_enabled();
+	};
+}
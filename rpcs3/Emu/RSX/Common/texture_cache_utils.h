@@ -3,6 +3,8 @@
 #include "texture_cache_types.h"
 #include "texture_cache_predictor.h"
 #include "TextureUtils.h"
+#include "page_lock_table.h"
+#include "interval_tree.h"
 
 #include "Emu/Memory/vm.h"
 #include "util/vm.hpp"
@@ -30,7 +32,8 @@ namespace rsx
 		ensure(range.is_page_range());
 
 		//rsx_log.error("memory_protect(0x%x, 0x%x, %x)", static_cast<u32>(range.start), static_cast<u32>(range.length()), static_cast<u32>(prot));
-		utils::memory_protect(vm::base(range.start), range.length(), prot);
+		// Goes through the page lock table so that pages shared with the strict vertex cache keep their write protection
+		page_lock_table.set_protection(range, prot);
 
 #ifdef TEXTURE_CACHE_DEBUG
 		tex_cache_checker.set_protection(range, prot);
@@ -225,38 +228,15 @@ namespace rsx
 		static constexpr u32 num_blocks = ranged_storage_type::num_blocks;
 		static constexpr u32 block_size = ranged_storage_type::block_size;
 
-		using unowned_container_type = std::unordered_set<section_storage_type*>;
-		using unowned_iterator = typename unowned_container_type::iterator;
-		using unowned_const_iterator = typename unowned_container_type::const_iterator;
-
 	private:
 		u32 index = 0;
 		address_range range = {};
 		block_container_type sections = {};
-		unowned_container_type unowned; // pointers to sections from other blocks that overlap this block
 		atomic_t<u32> exists_count = 0;
 		atomic_t<u32> locked_count = 0;
 		atomic_t<u32> unreleased_count = 0;
 		ranged_storage_type *m_storage = nullptr;
 
-		inline void add_owned_section_overlaps(section_storage_type &section)
-		{
-			u32 end = section.get_section_range().end;
-			for (auto *block = next_block(); block != nullptr && end >= block->get_start(); block = block->next_block())
-			{
-				block->add_unowned_section(section);
-			}
-		}
-
-		inline void remove_owned_section_overlaps(section_storage_type &section)
-		{
-			u32 end = section.get_section_range().end;
-			for (auto *block = next_block(); block != nullptr && end >= block->get_start(); block = block->next_block())
-			{
-				block->remove_unowned_section(section);
-			}
-		}
-
 	public:
 		// Construction
 		ranged_storage_block() = default;
@@ -372,20 +352,6 @@ namespace rsx
 			ensure(prev_locked > 0);
 		}
 
-		inline void on_section_range_valid(section_storage_type &section)
-		{
-			AUDIT(section.valid_range());
-			AUDIT(range.overlaps(section.get_section_base()));
-			add_owned_section_overlaps(section);
-		}
-
-		inline void on_section_range_invalid(section_storage_type &section)
-		{
-			AUDIT(section.valid_range());
-			AUDIT(range.overlaps(section.get_section_base()));
-			remove_owned_section_overlaps(section);
-		}
-
 		inline void on_section_resources_created(const section_storage_type &section)
 		{
 			(void)section; // silence unused warning without _AUDIT
@@ -424,36 +390,6 @@ namespace rsx
 			unreleased_count++;
 		}
 
-
-		/**
-		 * Overlapping sections
-		 */
-		inline bool contains_unowned(section_storage_type &section) const
-		{
-			return (unowned.find(&section) != unowned.end());
-		}
-
-		inline void add_unowned_section(section_storage_type &section)
-		{
-			AUDIT(overlaps(section));
-			AUDIT(section.get_section_base() < range.start);
-			AUDIT(!contains_unowned(section));
-			unowned.insert(&section);
-		}
-
-		inline void remove_unowned_section(section_storage_type &section)
-		{
-			AUDIT(overlaps(section));
-			AUDIT(section.get_section_base() < range.start);
-			AUDIT(contains_unowned(section));
-			unowned.erase(&section);
-		}
-
-		inline unowned_iterator unowned_begin() { return unowned.begin(); }
-		inline unowned_const_iterator unowned_begin() const { return unowned.begin(); }
-		inline unowned_iterator unowned_end() { return unowned.end(); }
-		inline unowned_const_iterator unowned_end() const { return unowned.end(); }
-		inline bool unowned_empty() const { return unowned.empty(); }
 	};
 
 
@@ -476,6 +412,9 @@ namespace rsx
 		std::unordered_set<block_type*> m_in_use;
 		bool m_purging = false;
 
+		// Page ranges of all the sections with a valid range, covers every section_bounds
+		interval_tree<section_storage_type*> m_section_index;
+
 	public:
 		atomic_t<u32> m_unreleased_texture_objects = { 0 }; //Number of invalidated objects not yet freed from memory
 		atomic_t<u64> m_texture_memory_in_use = { 0 };
@@ -549,6 +488,7 @@ namespace rsx
 			}
 
 			m_in_use.clear();
+			m_section_index.clear();
 
 			AUDIT(m_unreleased_texture_objects == 0);
 			AUDIT(m_texture_memory_in_use == 0);
@@ -663,6 +603,18 @@ namespace rsx
 			m_unreleased_texture_objects++;
 		}
 
+		void on_section_range_valid(section_storage_type &section)
+		{
+			AUDIT(section.valid_range());
+			m_section_index.insert(section.get_section_range().to_page_range(), &section);
+		}
+
+		void on_section_range_invalid(section_storage_type &section)
+		{
+			AUDIT(section.valid_range());
+			ensure(m_section_index.erase(&section));
+		}
+
 		void on_section_resources_created(const section_storage_type &section)
 		{
 			m_texture_memory_in_use += section.get_section_size();
@@ -692,179 +644,42 @@ namespace rsx
 		}
 
 		/**
-		 * Ranged Iterator
+		 * Overlap queries
 		 */
-		 // Iterator
-		template <typename T, typename unowned_iterator, typename section_iterator, typename block_type, typename parent_type>
-		class range_iterator_tmpl
+		// Calls func(section) for every section with a valid range overlapping range, in ascending address order.
+		// Returning false from func stops the query. Sections must not be created, reset or destroyed from func
+		template <typename F>
+		void for_each_overlap(const address_range &range, section_bounds bounds, bool locked_only, F&& func)
 		{
-		public:
-			// Traits
-			using value_type = T;
-			using pointer = T * ;
-			using difference_type = int;
-			using reference = T & ;
-			using iterator_category = std::forward_iterator_tag;
-
-			// Constructors
-			range_iterator_tmpl() = default; // end iterator
-
-			explicit range_iterator_tmpl(parent_type &storage, const address_range &_range, section_bounds _bounds, bool _locked_only)
-				: range(_range)
-				, bounds(_bounds)
-				, block(&storage.block_for(range.start))
-				, unowned_remaining(true)
-				, unowned_it(block->unowned_begin())
-				, cur_block_it(block->begin())
-				, locked_only(_locked_only)
-			{
-				// do a "fake" iteration to ensure the internal state is consistent
-				next(false);
-			}
-
-		private:
-			// Members
-			address_range range;
-			section_bounds bounds;
-
-			block_type *block = nullptr;
-			bool needs_overlap_check = true;
-			bool unowned_remaining = false;
-			unowned_iterator unowned_it = {};
-			section_iterator cur_block_it = {};
-			pointer obj = nullptr;
-			bool locked_only = false;
-
-			inline void next(bool iterate = true)
+			m_section_index.for_each_overlap(range, [&](section_storage_type* section)
 			{
-				AUDIT(block != nullptr);
-
-				if (unowned_remaining)
+				if ((locked_only && !section->is_locked()) || !section->overlaps(range, bounds))
 				{
-					do
-					{
-						// Still have "unowned" sections from blocks before the range to loop through
-						auto blk_end = block->unowned_end();
-						if (iterate && unowned_it != blk_end)
-						{
-							++unowned_it;
-						}
-
-						if (unowned_it != blk_end)
-						{
-							obj = *unowned_it;
-							if (obj->valid_range() && (!locked_only || obj->is_locked()) && obj->overlaps(range, bounds))
-								return;
-
-							iterate = true;
-							continue;
-						}
-
-						// No more unowned sections remaining
-						unowned_remaining = false;
-						iterate = false;
-						break;
-
-					} while (true);
+					return true;
 				}
 
-				// Go to next block
-				do
+				if constexpr (std::is_same_v<std::invoke_result_t<F&, section_storage_type&>, bool>)
 				{
-					// Iterate current block
-					do
-					{
-						auto blk_end = block->end();
-						if (iterate && cur_block_it != blk_end)
-						{
-							++cur_block_it;
-						}
-
-						if (cur_block_it != blk_end)
-						{
-							obj = &(*cur_block_it);
-							if (obj->valid_range() && (!locked_only || obj->is_locked()) && (!needs_overlap_check || obj->overlaps(range, bounds)))
-								return;
-
-							iterate = true;
-							continue;
-						}
-						break;
-
-					} while (true);
-
-					// Move to next block(s)
-					do
-					{
-						block = block->next_block();
-						if (block == nullptr || block->get_start() > range.end) // Reached end
-						{
-							block = nullptr;
-							obj = nullptr;
-							return;
-						}
-
-						needs_overlap_check = (block->get_end() > range.end);
-						cur_block_it = block->begin();
-						iterate = false;
-					} while (locked_only && block->get_locked_count() == 0); // find a block with locked sections
-
-				} while (true);
-			}
-
-		public:
-			inline reference operator*() const { return *obj; }
-			inline pointer operator->() const { return obj; }
-			inline reference operator++() { next(); return *obj; }
-			inline reference operator++(int) { auto *ptr = obj; next(); return *ptr; }
-			inline bool operator==(const range_iterator_tmpl &rhs) const { return obj == rhs.obj && unowned_remaining == rhs.unowned_remaining; }
-
-			inline void set_end(u32 new_end)
-			{
-				range.end = new_end;
-
-				// If we've exceeded the new end, invalidate iterator
-				if (block->get_start() > range.end)
+					return func(*section);
+				}
+				else
 				{
-					block = nullptr;
+					func(*section);
+					return true;
 				}
-			}
-
-			inline block_type& get_block() const
-			{
-				AUDIT(block != nullptr);
-				return *block;
-			}
-
-			inline section_bounds get_bounds() const
-			{
-				return bounds;
-			}
-		};
-
-		using range_iterator = range_iterator_tmpl<section_storage_type, typename block_type::unowned_iterator, typename block_type::iterator, block_type, ranged_storage>;
-		using range_const_iterator = range_iterator_tmpl<const section_storage_type, typename block_type::unowned_const_iterator, typename block_type::const_iterator, const block_type, const ranged_storage>;
-
-		inline range_iterator range_begin(const address_range &range, section_bounds bounds, bool locked_only = false) {
-			return range_iterator(*this, range, bounds, locked_only);
-		}
-
-		inline range_const_iterator range_begin(const address_range &range, section_bounds bounds, bool locked_only = false) const {
-			return range_const_iterator(*this, range, bounds, locked_only);
+			});
 		}
 
-		inline range_const_iterator range_begin(u32 address, section_bounds bounds, bool locked_only = false) const {
-			return range_const_iterator(*this, address_range::start_length(address, 1), bounds, locked_only);
-		}
-
-		constexpr range_iterator range_end()
+		bool overlaps(const address_range &range, section_bounds bounds, bool locked_only = false)
 		{
-			return range_iterator();
-		}
+			bool result = false;
+			for_each_overlap(range, bounds, locked_only, [&](section_storage_type&)
+			{
+				result = true;
+				return false;
+			});
 
-		constexpr range_const_iterator range_end() const
-		{
-			return range_const_iterator();
+			return result;
 		}
 
 		/**
@@ -1283,8 +1098,7 @@ namespace rsx
 			AUDIT(valid_range());
 
 			// Callbacks
-			m_block->on_section_range_valid(*derived());
-			//m_storage->on_section_range_valid(*derived());
+			m_storage->on_section_range_valid(*derived());
 
 			// Reset texture_cache m_flush_always_cache
 			if (readback_behaviour == memory_read_flags::flush_always)
@@ -1304,9 +1118,8 @@ namespace rsx
 				m_tex_cache->on_memory_read_flags_changed(*derived(), memory_read_flags::flush_once);
 			}
 
-			// Notify the storage block that we are now invalid
-			m_block->on_section_range_invalid(*derived());
-			//m_storage->on_section_range_invalid(*derived());
+			// Notify the storage that we are now invalid
+			m_storage->on_section_range_invalid(*derived());
 
 			m_predictor_entry = nullptr;
 			speculatively_flushed = false;
@@ -1441,7 +1254,7 @@ namespace rsx
 		{
 			speculatively_flushed = false;
 
-			m_tex_cache->on_flush();
+			m_tex_cache->on_flush(*derived());
 
 			if (tracked_by_predictor())
 			{
@@ -0,0 +1,118 @@
+#include "stdafx.h"
+#include "texture_upload_pool.h"
+#include "Utilities/Thread.h"
+
+#include "util/sysinfo.hpp"
+
+namespace rsx
+{
+	// Global list of worker threads
+	std::unique_ptr<named_thread_group<texture_upload_worker>> g_texture_upload_workers;
+	u32 g_num_texture_upload_workers = 0;
+	atomic_t<u32> g_texture_upload_worker_index{};
+
+	void texture_upload_worker::enqueue(texture_upload_batch* batch, job_func_t func)
+	{
+		m_work_queue.push(batch, std::move(func));
+	}
+
+	void texture_upload_worker::operator()()
+	{
+		while (thread_ctrl::state() != thread_state::aborting)
+		{
+			for (auto&& job : m_work_queue.pop_all())
+			{
+				std::exception_ptr exception;
+
+				try
+				{
+					job.func();
+				}
+				catch (...)
+				{
+					exception = std::current_exception();
+				}
+
+				job.batch->complete(std::move(exception));
+			}
+
+			thread_ctrl::wait_on(m_work_queue, nullptr);
+		}
+	}
+
+	texture_upload_batch::~texture_upload_batch()
+	{
+		// Never leave jobs referencing this batch behind, and never throw from here
+		std::unique_lock lock(m_mutex);
+		m_cv.wait(lock, [this]() { return m_pending == 0; });
+	}
+
+	void texture_upload_batch::complete(std::exception_ptr exception)
+	{
+		// Notify while holding the lock so that the waiter cannot destroy the batch under us
+		std::lock_guard lock(m_mutex);
+
+		if (exception && !m_exception)
+		{
+			m_exception = std::move(exception);
+		}
+
+		if (--m_pending == 0)
+		{
+			m_cv.notify_all();
+		}
+	}
+
+	void texture_upload_batch::submit(texture_upload_worker::job_func_t func)
+	{
+		if (!g_texture_upload_workers)
+		{
+			func();
+			return;
+		}
+
+		{
+			std::lock_guard lock(m_mutex);
+			m_pending++;
+		}
+
+		const u32 thread_index = g_texture_upload_worker_index++;
+		auto worker = g_texture_upload_workers->begin() + (thread_index % g_num_texture_upload_workers);
+		worker->enqueue(this, std::move(func));
+	}
+
+	void texture_upload_batch::wait()
+	{
+		std::unique_lock lock(m_mutex);
+		m_cv.wait(lock, [this]() { return m_pending == 0; });
+
+		if (m_exception)
+		{
+			std::rethrow_exception(std::exchange(m_exception, nullptr));
+		}
+	}
+
+	void initialize_texture_upload_workers(int num_worker_threads)
+	{
+		if (num_worker_threads <= 0)
+		{
+			// Leave room for the PPU/SPU threads, texture decode is memory bound anyway
+			const u32 hw_threads = utils::get_thread_count();
+			num_worker_threads = hw_threads > 8 ? 4 : (hw_threads >= 6 ? 2 : 1);
+		}
+
+		g_texture_upload_workers = std::make_unique<named_thread_group<texture_upload_worker>>("RSX.U", num_worker_threads);
+		g_num_texture_upload_workers = num_worker_threads;
+	}
+
+	void destroy_texture_upload_workers()
+	{
+		g_texture_upload_workers.reset();
+		g_num_texture_upload_workers = 0;
+	}
+
+	bool texture_upload_workers_active()
+	{
+		return !!g_texture_upload_workers;
+	}
+}
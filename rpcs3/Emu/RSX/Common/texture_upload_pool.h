@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Utilities/lockless.h"
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+
+namespace rsx
+{
+	class texture_upload_batch;
+
+	// Worker thread performing the CPU side of texture uploads (decode, endian swap, format conversion) into staging memory
+	class texture_upload_worker
+	{
+	public:
+		using job_func_t = std::function<void()>;
+
+		void enqueue(texture_upload_batch* batch, job_func_t func);
+		void operator()();
+
+	private:
+		struct upload_job
+		{
+			texture_upload_batch* batch;
+			job_func_t func;
+
+			upload_job(texture_upload_batch* batch, job_func_t func)
+				: batch(batch), func(std::move(func))
+			{}
+		};
+
+		lf_queue<upload_job> m_work_queue;
+	};
+
+	/**
+	 * Completion token for a group of upload jobs.
+	 * Jobs are distributed over the upload workers, or run inline if the worker pool is not running.
+	 * The owner must wait on the batch before consuming the staging memory; the destructor waits as well.
+	 * Exceptions thrown by a job are rethrown to the waiting thread.
+	 */
+	class texture_upload_batch
+	{
+		std::mutex m_mutex;
+		std::condition_variable m_cv;
+		u32 m_pending = 0;
+		std::exception_ptr m_exception;
+
+		friend class texture_upload_worker;
+		void complete(std::exception_ptr exception);
+
+	public:
+		texture_upload_batch() = default;
+		~texture_upload_batch();
+
+		texture_upload_batch(const texture_upload_batch&) = delete;
+		texture_upload_batch& operator=(const texture_upload_batch&) = delete;
+
+		void submit(texture_upload_worker::job_func_t func);
+		void wait();
+	};
+
+	void initialize_texture_upload_workers(int num_worker_threads);
+	void destroy_texture_upload_workers();
+	bool texture_upload_workers_active();
+}
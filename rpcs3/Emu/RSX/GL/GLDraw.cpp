@@ -624,6 +624,8 @@ void GLGSRender::end()
 		return;
 	}
 
+	m_frame_stats.program_lookup_time += m_profiler.duration();
+
 	// Load program execution environment
 	load_program_env();
 	m_frame_stats.setup_time += m_profiler.duration();
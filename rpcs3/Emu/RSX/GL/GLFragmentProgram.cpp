@@ -5,6 +5,9 @@
 #include "GLCommonDecompiler.h"
 #include "../GCM.h"
 #include "../Program/GLSLCommon.h"
+#include "../Program/decompiled_program_cache.h"
+
+#include "util/serialization.hpp"
 
 std::string GLFragmentDecompilerThread::getFloatTypeName(usz elementCount)
 {
@@ -360,21 +363,42 @@ void GLFragmentProgram::Decompile(const RSXFragmentProgram& prog)
 		decompiler.device_props.has_low_precision_rounding = driver_caps.vendor_NVIDIA;
 	}
 
-	decompiler.Task();
+	// Driver state baked into the generated source
+	const auto& driver_caps = gl::get_driver_caps();
+	utils::serial device_state;
+	device_state(decompiler.device_props.has_native_half_support, decompiler.device_props.has_low_precision_rounding,
+		driver_caps.NV_gpu_shader5_supported, driver_caps.vendor_NVIDIA);
 
-	for (const ParamType& PT : decompiler.m_parr.params[PF_PARAM_UNIFORM])
+	if (rsx::decompiled_program_cache_t::entry cached; rsx::decompiled_program_cache.find(prog, device_state.data, cached))
 	{
-		for (const ParamItem& PI : PT.items)
-		{
-			if (PT.type == "sampler1D" ||
-				PT.type == "sampler2D" ||
-				PT.type == "sampler3D" ||
-				PT.type == "samplerCube")
-				continue;
+		utils::serial metadata;
+		metadata.set_reading_state(std::move(cached.metadata));
+		metadata(FragmentConstantOffsetCache);
+
+		source = std::move(cached.source);
+	}
+	else
+	{
+		decompiler.Task();
 
-			usz offset = atoi(PI.name.c_str() + 2);
-			FragmentConstantOffsetCache.push_back(offset);
+		for (const ParamType& PT : decompiler.m_parr.params[PF_PARAM_UNIFORM])
+		{
+			for (const ParamItem& PI : PT.items)
+			{
+				if (PT.type == "sampler1D" ||
+					PT.type == "sampler2D" ||
+					PT.type == "sampler3D" ||
+					PT.type == "samplerCube")
+					continue;
+
+				usz offset = atoi(PI.name.c_str() + 2);
+				FragmentConstantOffsetCache.push_back(offset);
+			}
 		}
+
+		utils::serial metadata;
+		metadata(FragmentConstantOffsetCache);
+		rsx::decompiled_program_cache.store(prog, device_state.data, { source, std::move(metadata.data) });
 	}
 
 	shader.create(::glsl::program_domain::glsl_fragment_program, source);
@@ -17,11 +17,6 @@ GLGSRender::GLGSRender(utils::serial* ar) noexcept : GSRender(ar)
 {
 	m_shaders_cache = std::make_unique<gl::shader_cache>(m_prog_buffer, "opengl", "v1.91");
 
-	if (g_cfg.video.disable_vertex_cache || g_cfg.video.multithreaded_rsx)
-		m_vertex_cache = std::make_unique<gl::null_vertex_cache>();
-	else
-		m_vertex_cache = std::make_unique<gl::weak_vertex_cache>();
-
 	backend_config.supports_hw_a2c = false;
 	backend_config.supports_hw_a2one = false;
 	backend_config.supports_multidraw = true;
@@ -239,6 +234,21 @@ void GLGSRender::on_init_thread()
 	m_vertex_layout_buffer->create(gl::buffer::target::uniform, 16 * 0x100000);
 	m_raster_env_ring_buffer->create(gl::buffer::target::uniform, 16 * 0x100000);
 
+	// The vertex cache references data in the attrib heap, create it once the heap type is known
+	if (g_cfg.video.disable_vertex_cache || g_cfg.video.multithreaded_rsx)
+	{
+		m_vertex_cache = std::make_unique<gl::null_vertex_cache>();
+	}
+	else if (g_cfg.video.strict_vertex_cache)
+	{
+		// Legacy buffers are orphaned when they wrap around, nothing stored before that point survives
+		m_vertex_cache = std::make_unique<gl::strict_vertex_cache>(static_cast<u32>(m_attrib_ring_buffer->size()), manually_flush_ring_buffers);
+	}
+	else
+	{
+		m_vertex_cache = std::make_unique<gl::weak_vertex_cache>();
+	}
+
 	if (shadermode == shader_mode::async_with_interpreter || shadermode == shader_mode::interpreter_only)
 	{
 		m_vertex_instructions_buffer->create(gl::buffer::target::ssbo, 16 * 0x100000);
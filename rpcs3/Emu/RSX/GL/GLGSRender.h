@@ -20,6 +20,7 @@ namespace gl
 {
 	using vertex_cache = rsx::vertex_cache::default_vertex_cache<rsx::vertex_cache::uploaded_range<GLenum>, GLenum>;
 	using weak_vertex_cache = rsx::vertex_cache::weak_vertex_cache<GLenum>;
+	using strict_vertex_cache = rsx::vertex_cache::strict_vertex_cache<GLenum>;
 	using null_vertex_cache = vertex_cache;
 
 	using shader_cache = rsx::shaders_cache<void*, GLProgramBuffer>;
@@ -180,6 +181,8 @@ public:
 	void get_occlusion_query_result(rsx::reports::occlusion_query_info* query) override;
 	void discard_occlusion_query(rsx::reports::occlusion_query_info* query) override;
 
+	rsx::texture_cache_frame_statistics get_texture_cache_statistics() const override { return m_gl_texture_cache.get_last_frame_statistics(); }
+
 protected:
 	void clear_surface(u32 arg) override;
 	void begin() override;
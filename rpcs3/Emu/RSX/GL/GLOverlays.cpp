@@ -386,6 +386,7 @@ namespace gl
 		temp_image_cache.clear();
 		resources.clear();
 		font_cache.clear();
+		font_revision_cache.clear();
 		overlay_pass::destroy();
 	}
 
@@ -418,7 +419,8 @@ namespace gl
 			if (const auto this_size = found->second->image()->size3D();
 				font_size.width == this_size.width &&
 				font_size.height == this_size.height &&
-				font_size.depth == this_size.depth)
+				font_size.depth == this_size.depth &&
+				font_revision_cache[key] == font->get_glyph_data_revision())
 			{
 				return found->second.get();
 			}
@@ -437,6 +439,7 @@ namespace gl
 		auto result = view.get();
 		font_cache[key] = std::move(tex);
 		view_cache[key] = std::move(view);
+		font_revision_cache[key] = font->get_glyph_data_revision();
 
 		return result;
 	}
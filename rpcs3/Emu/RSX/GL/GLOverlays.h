@@ -79,6 +79,7 @@ namespace gl
 		std::unordered_map<u64, std::pair<u32, std::unique_ptr<gl::texture>>> temp_image_cache;
 		std::unordered_map<u64, std::unique_ptr<gl::texture_view>> temp_view_cache;
 		std::unordered_map<u64, std::unique_ptr<gl::texture>> font_cache;
+		std::unordered_map<u64, u64> font_revision_cache;
 		std::unordered_map<u64, std::unique_ptr<gl::texture_view>> view_cache;
 		rsx::overlays::primitive_type m_current_primitive_type = rsx::overlays::primitive_type::quad_list;
 
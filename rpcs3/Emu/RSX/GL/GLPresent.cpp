@@ -348,6 +348,7 @@ void GLGSRender::flip(const rsx::display_flip_info_t& info)
 		m_text_printer.print_text(4, 144, width, height, fmt::format("Texture memory: %12dM", texture_memory_size));
 		m_text_printer.print_text(4, 162, width, height, fmt::format("Flush requests: %12d  = %2d (%3d%%) hard faults, %2d unavoidable, %2d misprediction(s), %2d speculation(s)", num_flushes, num_misses, cache_miss_ratio, num_unavoidable, num_mispredict, num_speculate));
 		m_text_printer.print_text(4, 180, width, height, fmt::format("Texture uploads: %15u (%u from CPU - %02u%%)", num_texture_upload, num_texture_upload_miss, texture_upload_miss_ratio));
+		m_text_printer.print_text(4, 198, width, height, fmt::format("Program lookup: %12dus", info.stats.program_lookup_time));
 	}
 
 	if (gl::debug::g_vis_texture)
@@ -379,7 +380,7 @@ void GLGSRender::flip(const rsx::display_flip_info_t& info)
 
 	// Cleanup
 	m_gl_texture_cache.on_frame_end();
-	m_vertex_cache->purge();
+	m_vertex_cache->on_frame_end();
 
 	gl::command_context cmd{ gl_state };
 	auto removed_textures = m_rtts.free_invalidated(cmd);
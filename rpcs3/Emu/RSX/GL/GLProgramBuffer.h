@@ -140,9 +140,13 @@ struct GLProgramBuffer : public program_state_cache<GLTraits>
 		get_graphics_pipeline(vp, fp, props, false, false, std::forward<Args>(args)...);
 	}
 
-	void preload_programs(RSXVertexProgram &vp, RSXFragmentProgram &fp)
+	void preload_program(RSXVertexProgram &vp)
 	{
 		search_vertex_program(vp);
+	}
+
+	void preload_program(RSXFragmentProgram &fp)
+	{
 		search_fragment_program(fp);
 	}
 
@@ -58,8 +58,9 @@ namespace
 
 	struct draw_command_visitor
 	{
-		draw_command_visitor(gl::ring_buffer& index_ring_buffer, rsx::vertex_input_layout& vertex_layout)
+		draw_command_visitor(gl::ring_buffer& index_ring_buffer, rsx::index_array_cache& index_cache, rsx::vertex_input_layout& vertex_layout)
 			: m_index_ring_buffer(index_ring_buffer)
+			, m_index_cache(index_cache)
 			, m_vertex_layout(vertex_layout)
 		{}
 
@@ -104,9 +105,9 @@ namespace
 			void* ptr                  = mapping.first;
 			u32 offset_in_index_buffer = mapping.second;
 
-			std::tie(min_index, max_index, index_count) = write_index_array_data_to_buffer(
+			std::tie(min_index, max_index, index_count) = m_index_cache.write_index_array_data_to_buffer(
 				{ reinterpret_cast<std::byte*>(ptr), max_size },
-				command.raw_index_buffer, type,
+				command.raw_index_buffer, command.raw_index_address, type,
 				rsx::method_registers.current_draw_clause.primitive,
 				rsx::method_registers.restart_index_enabled(),
 				rsx::method_registers.restart_index(),
@@ -144,6 +145,7 @@ namespace
 
 	private:
 		gl::ring_buffer& m_index_ring_buffer;
+		rsx::index_array_cache& m_index_cache;
 		rsx::vertex_input_layout& m_vertex_layout;
 	};
 }
@@ -153,7 +155,7 @@ gl::vertex_upload_info GLGSRender::set_vertex_buffer()
 	m_profiler.start();
 
 	//Write index buffers and count verts
-	auto result = std::visit(draw_command_visitor(*m_index_ring_buffer, m_vertex_layout), get_draw_command(rsx::method_registers));
+	auto result = std::visit(draw_command_visitor(*m_index_ring_buffer, m_index_array_cache, m_vertex_layout), get_draw_command(rsx::method_registers));
 
 	const u32 vertex_count = (result.max_index - result.min_index) + 1;
 	u32 vertex_base = result.min_index;
@@ -184,7 +186,6 @@ gl::vertex_upload_info GLGSRender::set_vertex_buffer()
 	{
 		//Check if cacheable
 		//Only data in the 'persistent' block may be cached
-		//TODO: make vertex cache keep local data beyond frame boundaries and hook notify command
 		bool in_cache = false;
 		bool to_store = false;
 		u32  storage_address = -1;
@@ -212,6 +213,7 @@ gl::vertex_upload_info GLGSRender::set_vertex_buffer()
 		{
 			persistent_mapping = m_attrib_ring_buffer->alloc_from_heap(required.first, m_min_texbuffer_alignment);
 			upload_info.persistent_mapping_offset = persistent_mapping.second;
+			m_vertex_cache->notify_heap_allocation(persistent_mapping.second, required.first);
 
 			if (to_store)
 			{
@@ -236,6 +238,7 @@ gl::vertex_upload_info GLGSRender::set_vertex_buffer()
 	{
 		volatile_mapping = m_attrib_ring_buffer->alloc_from_heap(required.second, m_min_texbuffer_alignment);
 		upload_info.volatile_mapping_offset = volatile_mapping.second;
+		m_vertex_cache->notify_heap_allocation(volatile_mapping.second, required.second);
 
 		if (!m_volatile_stream_view.in_range(upload_info.volatile_mapping_offset, required.second, upload_info.volatile_mapping_offset))
 		{
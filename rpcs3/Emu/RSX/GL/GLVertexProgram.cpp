@@ -5,6 +5,9 @@
 
 #include "GLCommonDecompiler.h"
 #include "../Program/GLSLCommon.h"
+#include "../Program/decompiled_program_cache.h"
+
+#include "util/serialization.hpp"
 
 #include <algorithm>
 
@@ -269,8 +272,21 @@ GLVertexProgram::~GLVertexProgram()
 void GLVertexProgram::Decompile(const RSXVertexProgram& prog)
 {
 	std::string source;
-	GLVertexDecompilerThread decompiler(prog, source, parr);
-	decompiler.Task();
+
+	utils::serial device_state;
+	device_state(gl::get_driver_caps().NV_depth_buffer_float_supported);
+
+	if (rsx::decompiled_program_cache_t::entry cached; rsx::decompiled_program_cache.find(prog, device_state.data, cached))
+	{
+		source = std::move(cached.source);
+	}
+	else
+	{
+		GLVertexDecompilerThread decompiler(prog, source, parr);
+		decompiler.Task();
+
+		rsx::decompiled_program_cache.store(prog, device_state.data, { source, {} });
+	}
 
 	shader.create(::glsl::program_domain::glsl_vertex_program, source);
 	id = shader.id();
@@ -1,6 +1,8 @@
 #include "stdafx.h"
 #include "overlay_controls.h"
 #include "Emu/system_config.h"
+#include "Utilities/File.h"
+#include "util/asm.hpp"
 
 #ifndef _WIN32
 #include <unistd.h>
@@ -16,39 +18,40 @@ namespace rsx
 {
 	namespace overlays
 	{
-		void codepage::initialize_glyphs(char32_t codepage_id, f32 font_size, const std::vector<u8>& ttf_data)
+		bool glyph_atlas_layer::allocate(u16 w, u16 h, u16& x, u16& y)
 		{
-			glyph_base = (codepage_id * 256);
-			glyph_data.resize(bitmap_width * bitmap_height);
-			pack_info.resize(256);
-
-			stbtt_pack_context context;
-			if (!stbtt_PackBegin(&context, glyph_data.data(), bitmap_width, bitmap_height, 0, 1, nullptr))
+			if (w > bitmap_width || h > bitmap_height)
 			{
-				rsx_log.error("Font packing failed");
-				return;
+				return false;
 			}
 
-			stbtt_PackSetOversampling(&context, oversample, oversample);
+			// Prefer the lowest shelf the glyph fits in
+			shelf* best = nullptr;
 
-			if (!stbtt_PackFontRange(&context, ttf_data.data(), 0, font_size, (codepage_id * 256), 256, pack_info.data()))
+			for (auto& row : shelves)
 			{
-				rsx_log.error("Font packing failed");
-				stbtt_PackEnd(&context);
-				return;
+				if (row.height >= h && row.x + w <= bitmap_width && (!best || row.height < best->height))
+				{
+					best = &row;
+				}
 			}
 
-			stbtt_PackEnd(&context);
-		}
+			// Open a new shelf instead of wasting more than half of an existing one
+			if ((!best || best->height / 2 > h) && top + h <= bitmap_height)
+			{
+				best = &shelves.emplace_back(shelf{ static_cast<u16>(top), h, 0 });
+				top += h;
+			}
 
-		stbtt_aligned_quad codepage::get_char(char32_t c, f32& x_advance, f32& y_advance)
-		{
-			stbtt_aligned_quad quad;
-			stbtt_GetPackedQuad(pack_info.data(), bitmap_width, bitmap_height, (c - glyph_base), &x_advance, &y_advance, &quad, false);
+			if (!best)
+			{
+				return false;
+			}
 
-			quad.t0 += sampler_z;
-			quad.t1 += sampler_z;
-			return quad;
+			x = best->x;
+			y = best->y;
+			best->x += w;
+			return true;
 		}
 
 		font::font(const char* ttf_name, f32 size)
@@ -59,6 +62,30 @@ namespace rsx
 
 			font_name = ttf_name;
 			initialized = true;
+
+			load_atlas_cache();
+
+			if (m_layers.empty())
+			{
+				// Renderers always expect at least one layer
+				m_layers.emplace_back();
+			}
+
+			f32 unused;
+			get_char('m', em_size, unused);
+		}
+
+		font::~font()
+		{
+			flush_atlas_cache();
+		}
+
+		void font::flush_atlas_cache()
+		{
+			if (m_revision != m_saved_revision)
+			{
+				save_atlas_cache();
+			}
 		}
 
 		language_class font::classify(char32_t codepage_id)
@@ -169,25 +196,16 @@ namespace rsx
 			return result;
 		}
 
-		codepage* font::initialize_codepage(char32_t codepage_id)
+		std::string font::find_font_file(language_class class_) const
 		{
-			// Init glyph
-			const auto class_ = classify(codepage_id);
 			const auto fs_settings = get_glyph_files(class_);
 
-			// Attemt to load requested font
-			std::vector<u8> bytes;
-			std::string file_path;
-			bool font_found = false;
-
 			for (const auto& font_file : fs_settings.font_names)
 			{
 				if (fs::is_file(font_file))
 				{
 					// Check for absolute paths or fonts 'installed' to executable folder
-					file_path = font_file;
-					font_found = true;
-					break;
+					return font_file;
 				}
 
 				std::string extension;
@@ -206,81 +224,150 @@ namespace rsx
 
 				for (const auto& font_dir : fs_settings.lookup_font_dirs)
 				{
-					file_path = font_dir + file_name;
-					if (fs::is_file(file_path))
+					if (std::string file_path = font_dir + file_name; fs::is_file(file_path))
 					{
-						font_found = true;
-						break;
+						return file_path;
 					}
 				}
-
-				if (font_found)
-				{
-					break;
-				}
 			}
 
-			// Read font
-			if (font_found)
+			return {};
+		}
+
+		const std::vector<u8>* font::load_font_data(language_class class_)
+		{
+			auto& source = m_sources[static_cast<u32>(class_)];
+
+			if (!source.data.empty())
 			{
-				fs::file f(file_path);
-				f.read(bytes, f.size());
+				return &source.data;
 			}
-			else
+
+			if (source.load_failed)
 			{
-				rsx_log.error("Failed to initialize font '%s.ttf' on codepage %d", font_name, static_cast<u32>(codepage_id));
 				return nullptr;
 			}
 
-			codepage_cache.page = nullptr;
-			auto page = std::make_unique<codepage>();
-			page->initialize_glyphs(codepage_id, size_px, bytes);
-			page->sampler_z = static_cast<f32>(m_glyph_map.size());
+			// Attempt to load requested font
+			const std::string file_path = find_font_file(class_);
+			fs::file f;
 
-			auto ret = page.get();
-			m_glyph_map.emplace_back(codepage_id, std::move(page));
+			if (file_path.empty() || !f.open(file_path))
+			{
+				rsx_log.error("Failed to initialize font '%s.ttf' for language class %d", font_name, static_cast<u32>(class_));
+				source.load_failed = true;
+				return nullptr;
+			}
 
-			if (codepage_id == 0)
+			if (!source.path.empty() && (source.path != file_path || source.file_size != f.size()))
 			{
-				// Latin-1
-				f32 unused;
-				get_char('m', em_size, unused);
+				// Cached glyphs were validated against the same lookup, this should not happen
+				rsx_log.warning("Font file for language class %d changed to '%s'", static_cast<u32>(class_), file_path);
 			}
 
-			return ret;
+			f.read(source.data, f.size());
+			source.path = file_path;
+			source.file_size = source.data.size();
+			return &source.data;
 		}
 
-		stbtt_aligned_quad font::get_char(char32_t c, f32& x_advance, f32& y_advance)
+		const glyph_info* font::rasterize_glyph(char32_t c)
 		{
-			if (!initialized)
-				return {};
+			const auto ttf_data = load_font_data(classify(c >> 8));
 
-			const auto page_id = (c >> 8);
-			if (codepage_cache.codepage_id == page_id && codepage_cache.page) [[likely]]
+			if (!ttf_data)
 			{
-				return codepage_cache.page->get_char(c, x_advance, y_advance);
+				return nullptr;
 			}
-			else
+
+			// Rasterize the glyph alone into a scratch bitmap, then copy its box into the atlas
+			stbtt_packedchar pack_info{};
+			std::vector<u8> scratch;
+			bool packed = false;
+
+			for (u32 scratch_size = utils::align<u32>(static_cast<u32>(size_px) * oversample * 2, 64); scratch_size <= glyph_atlas_layer::bitmap_width; scratch_size *= 2)
 			{
-				codepage_cache.codepage_id = page_id;
-				codepage_cache.page = nullptr;
+				// Cleared by stbtt_PackBegin
+				scratch.resize(scratch_size * scratch_size);
 
-				for (const auto& e : m_glyph_map)
+				stbtt_pack_context context;
+				if (!stbtt_PackBegin(&context, scratch.data(), scratch_size, scratch_size, 0, padding, nullptr))
 				{
-					if (e.first == unsigned(page_id))
-					{
-						codepage_cache.page = e.second.get();
-						break;
-					}
+					break;
 				}
 
-				if (!codepage_cache.page) [[unlikely]]
+				stbtt_PackSetOversampling(&context, oversample, oversample);
+				packed = stbtt_PackFontRange(&context, ttf_data->data(), 0, size_px, c, 1, &pack_info);
+				stbtt_PackEnd(&context);
+
+				if (packed)
 				{
-					codepage_cache.page = initialize_codepage(page_id);
+					const u32 scratch_stride = scratch_size;
+					const u16 w = pack_info.x1 - pack_info.x0;
+					const u16 h = pack_info.y1 - pack_info.y0;
+					u16 x = 0, y = 0;
+
+					if (w && h)
+					{
+						// Keep a blank border between glyphs for filtering
+						if (!m_layers.back().allocate(w + padding, h + padding, x, y))
+						{
+							ensure(m_layers.emplace_back().allocate(w + padding, h + padding, x, y));
+						}
+
+						x += padding;
+						y += padding;
+
+						auto& layer = m_layers.back();
+						for (u32 row = 0; row < h; row++)
+						{
+							std::memcpy(&layer.pixels[(y + row) * glyph_atlas_layer::bitmap_width + x], &scratch[(pack_info.y0 + row) * scratch_stride + pack_info.x0], w);
+						}
+					}
+
+					pack_info.x0 = x;
+					pack_info.y0 = y;
+					pack_info.x1 = x + w;
+					pack_info.y1 = y + h;
+					break;
 				}
+			}
 
-				return codepage_cache.page->get_char(c, x_advance, y_advance);
+			if (!packed)
+			{
+				// Keep an empty glyph so that the failure is not retried on every frame
+				rsx_log.error("Font packing failed for U+%04X ('%s')", static_cast<u32>(c), font_name);
+				pack_info = {};
 			}
+
+			m_revision++;
+
+			const u32 layer = ::size32(m_layers) - 1;
+			return &m_glyphs.insert_or_assign(c, glyph_info{ pack_info, layer }).first->second;
+		}
+
+		stbtt_aligned_quad font::get_char(char32_t c, f32& x_advance, f32& y_advance)
+		{
+			if (!initialized)
+				return {};
+
+			const glyph_info* glyph = nullptr;
+
+			if (const auto found = m_glyphs.find(c); found != m_glyphs.end()) [[likely]]
+			{
+				glyph = &found->second;
+			}
+			else if (glyph = rasterize_glyph(c); !glyph)
+			{
+				return {};
+			}
+
+			stbtt_aligned_quad quad;
+			stbtt_GetPackedQuad(&glyph->pack_info, glyph_atlas_layer::bitmap_width, glyph_atlas_layer::bitmap_height, 0, &x_advance, &y_advance, &quad, false);
+
+			quad.t0 += static_cast<f32>(glyph->layer);
+			quad.t1 += static_cast<f32>(glyph->layer);
+			return quad;
 		}
 
 		void font::render_text_ex(std::vector<vertex>& result, f32& x_advance, f32& y_advance, const char32_t* text, u32 char_limit, u16 max_width, bool wrap)
@@ -437,18 +524,258 @@ namespace rsx
 			return {loc_x, loc_y};
 		}
 
-		void font::get_glyph_data(std::vector<u8>& bytes) const
+		void font::get_glyph_data(std::vector<u8>& bytes)
 		{
-			const u32 page_size = codepage::bitmap_width * codepage::bitmap_height;
-			const auto size = page_size * m_glyph_map.size();
+			const u32 layer_size = glyph_atlas_layer::bitmap_width * glyph_atlas_layer::bitmap_height;
 
-			bytes.resize(size);
+			bytes.resize(layer_size * m_layers.size());
 			u8* data = bytes.data();
 
-			for (const auto& e : m_glyph_map)
+			for (const auto& layer : m_layers)
+			{
+				std::memcpy(data, layer.pixels.data(), layer_size);
+				data += layer_size;
+			}
+
+			// The atlas is read back after new glyphs were added, persist it from time to time
+			if (m_revision != m_saved_revision && steady_clock::now() - m_last_save >= 5s)
+			{
+				save_atlas_cache();
+			}
+		}
+
+		std::string font::get_atlas_cache_path() const
+		{
+			std::string name = font_name;
+
+			for (char& ch : name)
+			{
+				if (!std::isalnum(static_cast<uchar>(ch)) && ch != '-')
+				{
+					ch = '_';
+				}
+			}
+
+			return fmt::format("%soverlay_fonts/%s_%u.atlas", fs::get_cache_dir(), name, static_cast<u32>(size_px));
+		}
+
+		namespace
+		{
+			constexpr u64 atlas_file_magic = "RSXFONTA"_u64;
+			constexpr u32 atlas_file_version = 1;
+
+			struct atlas_file_header
+			{
+				u64 magic;
+				u32 version;
+				u32 layer_width;
+				u32 layer_height;
+				u32 oversample;
+				f32 size_px;
+				u32 layer_count;
+				u32 glyph_count;
+				u32 source_count;
+			};
+
+			struct atlas_file_source
+			{
+				u32 language;
+				u32 path_length;
+				u64 file_size;
+			};
+
+			struct atlas_file_glyph
+			{
+				u32 codepoint;
+				u32 layer;
+				stbtt_packedchar pack_info;
+			};
+
+			struct atlas_file_layer
+			{
+				u32 top;
+				u32 shelf_count;
+			};
+		}
+
+		void font::load_atlas_cache()
+		{
+			const std::string path = get_atlas_cache_path();
+			fs::file f;
+
+			if (!fs::is_file(path) || !f.open(path))
+			{
+				return;
+			}
+
+			const std::vector<u8> contents = f.to_vector<u8>();
+			usz pos = 0;
+
+			const auto read = [&](void* dst, usz size)
+			{
+				if (contents.size() - pos < size)
+				{
+					return false;
+				}
+
+				std::memcpy(dst, contents.data() + pos, size);
+				pos += size;
+				return true;
+			};
+
+			const auto reject = [&](std::string_view reason)
+			{
+				rsx_log.notice("Discarding font atlas cache '%s' (%s)", path, reason);
+				m_glyphs.clear();
+				m_layers.clear();
+
+				for (auto& source : m_sources)
+				{
+					source = {};
+				}
+			};
+
+			atlas_file_header header{};
+			if (!read(&header, sizeof(header)) ||
+				header.magic != atlas_file_magic ||
+				header.version != atlas_file_version ||
+				header.layer_width != glyph_atlas_layer::bitmap_width ||
+				header.layer_height != glyph_atlas_layer::bitmap_height ||
+				header.oversample != oversample ||
+				header.size_px != size_px ||
+				header.source_count > m_sources.size())
+			{
+				return reject("incompatible");
+			}
+
+			// The font files must still be the ones the glyphs were rasterized from
+			for (u32 i = 0; i < header.source_count; i++)
+			{
+				atlas_file_source source{};
+				std::string source_path;
+
+				if (!read(&source, sizeof(source)) || source.language >= m_sources.size() || source.path_length > 0x1000)
+				{
+					return reject("corrupt");
+				}
+
+				source_path.resize(source.path_length);
+
+				if (!read(source_path.data(), source_path.size()))
+				{
+					return reject("corrupt");
+				}
+
+				fs::stat_t stat{};
+				if (find_font_file(static_cast<language_class>(source.language)) != source_path || !fs::stat(source_path, stat) || stat.size != source.file_size)
+				{
+					return reject("font files changed");
+				}
+
+				m_sources[source.language].path = std::move(source_path);
+				m_sources[source.language].file_size = source.file_size;
+			}
+
+			for (u32 i = 0; i < header.glyph_count; i++)
+			{
+				atlas_file_glyph glyph{};
+
+				if (!read(&glyph, sizeof(glyph)) || glyph.layer >= header.layer_count)
+				{
+					return reject("corrupt");
+				}
+
+				m_glyphs.emplace(glyph.codepoint, glyph_info{ glyph.pack_info, glyph.layer });
+			}
+
+			m_layers.resize(header.layer_count);
+
+			for (auto& layer : m_layers)
+			{
+				atlas_file_layer info{};
+
+				if (!read(&info, sizeof(info)) || info.top > glyph_atlas_layer::bitmap_height || info.shelf_count > glyph_atlas_layer::bitmap_height)
+				{
+					return reject("corrupt");
+				}
+
+				layer.top = info.top;
+				layer.shelves.resize(info.shelf_count);
+
+				if (!read(layer.shelves.data(), layer.shelves.size() * sizeof(glyph_atlas_layer::shelf)) ||
+					!read(layer.pixels.data(), layer.pixels.size()))
+				{
+					return reject("corrupt");
+				}
+			}
+
+			rsx_log.notice("Loaded %u glyphs of font '%s' (%upx) from the atlas cache", m_glyphs.size(), font_name, static_cast<u32>(size_px));
+		}
+
+		void font::save_atlas_cache()
+		{
+			m_saved_revision = m_revision;
+			m_last_save = steady_clock::now();
+
+			const std::string path = get_atlas_cache_path();
+
+			if (!fs::create_path(fs::get_parent_dir(path)))
+			{
+				rsx_log.error("Failed to create font atlas cache directory for '%s' (%s)", path, fs::g_tls_error);
+				return;
+			}
+
+			std::vector<u8> contents;
+
+			const auto write = [&](const void* src, usz size)
+			{
+				contents.insert(contents.end(), static_cast<const u8*>(src), static_cast<const u8*>(src) + size);
+			};
+
+			u32 source_count = 0;
+			for (const auto& source : m_sources)
+			{
+				source_count += !source.path.empty();
+			}
+
+			const atlas_file_header header
+			{
+				atlas_file_magic, atlas_file_version, glyph_atlas_layer::bitmap_width, glyph_atlas_layer::bitmap_height,
+				oversample, size_px, ::size32(m_layers), ::size32(m_glyphs), source_count
+			};
+
+			contents.reserve(sizeof(header) + m_glyphs.size() * sizeof(atlas_file_glyph) + m_layers.size() * (glyph_atlas_layer::bitmap_width * glyph_atlas_layer::bitmap_height + 0x1000));
+			write(&header, sizeof(header));
+
+			for (u32 i = 0; i < m_sources.size(); i++)
+			{
+				if (const auto& source = m_sources[i]; !source.path.empty())
+				{
+					const atlas_file_source info{ i, ::size32(source.path), source.file_size };
+					write(&info, sizeof(info));
+					write(source.path.data(), source.path.size());
+				}
+			}
+
+			for (const auto& [codepoint, glyph] : m_glyphs)
+			{
+				const atlas_file_glyph info{ static_cast<u32>(codepoint), glyph.layer, glyph.pack_info };
+				write(&info, sizeof(info));
+			}
+
+			for (const auto& layer : m_layers)
+			{
+				const atlas_file_layer info{ layer.top, ::size32(layer.shelves) };
+				write(&info, sizeof(info));
+				write(layer.shelves.data(), layer.shelves.size() * sizeof(glyph_atlas_layer::shelf));
+				write(layer.pixels.data(), layer.pixels.size());
+			}
+
+			fs::pending_file temp(path);
+
+			if (!temp.file || temp.file.write(contents.data(), contents.size()) != contents.size() || !temp.commit())
 			{
-				std::memcpy(data, e.second->glyph_data.data(), page_size);
-				data += page_size;
+				rsx_log.error("Failed to write font atlas cache '%s' (%s)", path, fs::g_tls_error);
 			}
 		}
 	} // namespace overlays
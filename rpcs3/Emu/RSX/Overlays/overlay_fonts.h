@@ -3,7 +3,9 @@
 #include "util/types.hpp"
 #include "overlay_utils.h"
 
+#include <array>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 // STB_IMAGE_IMPLEMENTATION and STB_TRUETYPE_IMPLEMENTATION defined externally
@@ -27,49 +29,79 @@ namespace rsx
 			std::vector<std::string> lookup_font_dirs;
 		};
 
-		// Each 'page' holds an indexed block of 256 code points
-		// The BMP (Basic Multilingual Plane) has 256 allocated pages but not all are necessary
-		// While there are supplementary planes, the BMP is the most important thing to support
-		struct codepage
+		// Glyphs are rasterized on first use and packed into an atlas made of fixed size layers
+		struct glyph_atlas_layer
 		{
 			static constexpr u32 bitmap_width = 1024;
 			static constexpr u32 bitmap_height = 1024;
-			static constexpr u32 char_count = 256; // 16x16 grid at max 48pt
-			static constexpr u32 oversample = 2;
 
-			std::vector<stbtt_packedchar> pack_info;
-			std::vector<u8> glyph_data;
-			char32_t glyph_base = 0;
-			f32 sampler_z = 0.f;
+			// Row of glyphs of similar height, filled from left to right
+			struct shelf
+			{
+				u16 y;
+				u16 height;
+				u16 x;
+			};
 
-			void initialize_glyphs(char32_t codepage_id, f32 font_size, const std::vector<u8>& ttf_data);
-			stbtt_aligned_quad get_char(char32_t c, f32& x_advance, f32& y_advance);
+			std::vector<u8> pixels = std::vector<u8>(bitmap_width * bitmap_height);
+			std::vector<shelf> shelves;
+			u32 top = 0; // First row not used by any shelf
+
+			// Reserves a w*h block, returns false if the layer is full
+			bool allocate(u16 w, u16 h, u16& x, u16& y);
+		};
+
+		struct glyph_info
+		{
+			stbtt_packedchar pack_info; // Atlas coordinates are relative to the layer
+			u32 layer;
 		};
 
 		class font
 		{
 		private:
+			static constexpr u32 oversample = 2;
+			static constexpr u32 padding = 1;
+
+			// Font file loaded for a language class
+			struct font_source
+			{
+				std::string path;
+				u64 file_size = 0;
+				std::vector<u8> data;
+				bool load_failed = false;
+			};
+
 			f32 size_pt = 12.f;
 			f32 size_px = 16.f; // Default font 12pt size
 			f32 em_size = 0.f;
 			std::string font_name;
 
-			std::vector<std::pair<char32_t, std::unique_ptr<codepage>>> m_glyph_map;
+			std::unordered_map<char32_t, glyph_info> m_glyphs;
+			std::vector<glyph_atlas_layer> m_layers;
+			std::array<font_source, 3> m_sources;
 			bool initialized = false;
 
-			struct
-			{
-				char32_t codepage_id = 0;
-				codepage* page = nullptr;
-			}
-			codepage_cache;
+			// Atlas revision, bumped whenever glyphs are added
+			u64 m_revision = 0;
+			u64 m_saved_revision = 0;
+			steady_clock::time_point m_last_save{};
 
 			static language_class classify(char32_t codepage_id);
 			glyph_load_setup get_glyph_files(language_class class_) const;
-			codepage* initialize_codepage(char32_t codepage_id);
+			std::string find_font_file(language_class class_) const;
+			const std::vector<u8>* load_font_data(language_class class_);
+			const glyph_info* rasterize_glyph(char32_t c);
+
+			// Rasterized glyphs are kept in the cache directory per font and size
+			std::string get_atlas_cache_path() const;
+			void load_atlas_cache();
+			void save_atlas_cache();
+
 		public:
 
 			font(const char* ttf_name, f32 size);
+			~font();
 
 			stbtt_aligned_quad get_char(char32_t c, f32& x_advance, f32& y_advance);
 
@@ -85,9 +117,13 @@ namespace rsx
 			f32 get_size_px() const { return size_px; }
 			f32 get_em_size() const { return em_size; }
 
-			// Renderer info
-			size3u get_glyph_data_dimensions() const { return { codepage::bitmap_width, codepage::bitmap_height, ::size32(m_glyph_map) }; }
-			void get_glyph_data(std::vector<u8>& bytes) const;
+			// Renderer info. The glyph data has to be uploaded again whenever the revision changes
+			size3u get_glyph_data_dimensions() const { return { glyph_atlas_layer::bitmap_width, glyph_atlas_layer::bitmap_height, ::size32(m_layers) }; }
+			u64 get_glyph_data_revision() const { return m_revision; }
+			void get_glyph_data(std::vector<u8>& bytes);
+
+			// Writes the atlas cache if glyphs were added since the last save
+			void flush_atlas_cache();
 		};
 
 		// TODO: Singletons are cancer
@@ -128,6 +164,16 @@ namespace rsx
 
 				return m_instance->find(name, size);
 			}
+
+			// The manager is never destroyed, the atlas caches are written out when the renderer exits
+			static void flush()
+			{
+				if (m_instance)
+				{
+					for (auto& f : m_instance->fonts)
+						f->flush_atlas_cache();
+				}
+			}
 		};
 	}
 }
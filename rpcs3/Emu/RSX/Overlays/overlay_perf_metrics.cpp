@@ -301,6 +301,15 @@ namespace rsx
 			m_force_repaint = true;
 		}
 
+		void perf_metrics_overlay::set_texture_cache_stats_enabled(bool enabled)
+		{
+			if (m_texture_cache_stats_enabled == enabled)
+				return;
+
+			m_texture_cache_stats_enabled = enabled;
+			m_force_update = true;
+		}
+
 		void perf_metrics_overlay::set_framerate_datapoint_count(u32 datapoint_count)
 		{
 			if (m_fps_graph.get_datapoint_count() == datapoint_count)
@@ -568,6 +577,31 @@ namespace rsx
 				}
 				}
 
+				if (m_texture_cache_stats_enabled)
+				{
+					// Last complete frame, the counters of the current one are still moving
+					const auto stats = g_fxo->get<rsx::thread>().get_texture_cache_statistics();
+
+					if (!perf_text.empty())
+					{
+						perf_text += "\n\n";
+					}
+
+					perf_text += fmt::format("Texture Cache:\n"
+					                         " Lookups   : %u (%u uploaded, %u KiB)\n"
+					                         " Flushes   : %u (%u hard faults, %u KiB)\n"
+					                         " Predictor : %03.1f %% (%u speculated, %u mispredicted)\n"
+					                         " Blits     : %u\n"
+					                         " Time (us) : %u lookup, %u upload, %u blit\n"
+					                         "             %u fault, %u flush",
+					    stats.lookups, stats.uploads, stats.upload_bytes / 1024,
+					    stats.flushes, stats.hard_faults, stats.flush_bytes / 1024,
+					    stats.get_predictor_accuracy() * 100.f, stats.speculative_readbacks, stats.mispredictions,
+					    stats.blits,
+					    stats.lookup_time, stats.upload_time, stats.blit_time,
+					    stats.invalidate_time, stats.flush_time);
+				}
+
 				m_body.set_text(perf_text);
 
 				if (perf_text.empty())
@@ -909,6 +943,7 @@ namespace rsx
 					perf_overlay->set_frametime_datapoint_count(perf_settings.frametime_datapoint_count);
 					perf_overlay->set_framerate_graph_enabled(perf_settings.framerate_graph_enabled.get());
 					perf_overlay->set_frametime_graph_enabled(perf_settings.frametime_graph_enabled.get());
+					perf_overlay->set_texture_cache_stats_enabled(perf_settings.texture_cache_stats.get());
 					perf_overlay->set_graph_detail_levels(perf_settings.framerate_graph_detail_level.get(), perf_settings.frametime_graph_detail_level.get());
 					perf_overlay->init();
 				}
@@ -27,6 +27,7 @@ namespace rsx
 
 			bool m_framerate_graph_enabled{};
 			bool m_frametime_graph_enabled{};
+			bool m_texture_cache_stats_enabled{};
 			graph m_fps_graph;
 			graph m_frametime_graph;
 
@@ -87,6 +88,7 @@ namespace rsx
 
 			void set_framerate_graph_enabled(bool enabled);
 			void set_frametime_graph_enabled(bool enabled);
+			void set_texture_cache_stats_enabled(bool enabled);
 			void set_framerate_datapoint_count(u32 datapoint_count);
 			void set_frametime_datapoint_count(u32 datapoint_count);
 			void set_graph_detail_levels(perf_graph_detail_level framerate_level, perf_graph_detail_level frametime_level);
@@ -4,9 +4,48 @@
 
 #include <stack>
 #include "util/v128.hpp"
+#include "util/asm.hpp"
+
+#include <emmintrin.h>
 
 using namespace program_hash_util;
 
+namespace
+{
+	// SSE2 multiply-accumulate in the style of xxh3. Each instruction is mixed with a key that advances with the
+	// instruction count so the result depends on the order, and the accumulator chain is a single add per instruction
+	struct ucode_lookup_hasher
+	{
+		__m128i acc = _mm_set_epi64x(0x9E3779B185EBCA87ull, 0xC2B2AE3D27D4EB4Full);
+		__m128i key = _mm_set_epi64x(0x165667B19E3779F9ull, 0x85EBCA77C2B2AE63ull);
+		u32 count = 0;
+
+		FORCE_INLINE void update(const v128& inst)
+		{
+			const __m128i data_key = _mm_xor_si128(inst.vi, key);
+			const __m128i data_key_hi = _mm_shuffle_epi32(data_key, _MM_SHUFFLE(0, 3, 0, 1));
+			const __m128i product = _mm_mul_epu32(data_key, data_key_hi);
+			const __m128i data_swap = _mm_shuffle_epi32(inst.vi, _MM_SHUFFLE(1, 0, 3, 2));
+
+			acc = _mm_add_epi64(acc, _mm_add_epi64(product, data_swap));
+			key = _mm_add_epi64(key, _mm_set1_epi64x(0x27D4EB2F165667C5ull));
+			count++;
+		}
+
+		usz finalize() const
+		{
+			v128 result;
+			result.vi = acc;
+
+			u64 hash = result._u64[0] ^ utils::rol64(result._u64[1], 31) ^ (u64{count} * 0x9E3779B185EBCA87ull);
+			hash ^= hash >> 37;
+			hash *= 0x165667919E3779F9ull;
+			hash ^= hash >> 32;
+			return hash ? hash : 1; // Zero means not computed
+		}
+	};
+}
+
 usz vertex_program_utils::get_vertex_program_ucode_hash(const RSXVertexProgram &program)
 {
 	// 64-bit Fowler/Noll/Vo FNV-1a hash code
@@ -30,6 +69,27 @@ usz vertex_program_utils::get_vertex_program_ucode_hash(const RSXVertexProgram &
 	return hash;
 }
 
+usz vertex_program_utils::get_vertex_program_lookup_hash(const RSXVertexProgram &program)
+{
+	if (program.lookup_hash)
+	{
+		return program.lookup_hash;
+	}
+
+	ucode_lookup_hasher hasher;
+	const void* instbuffer = program.data.data();
+
+	for (unsigned i = 0; i < program.data.size() / 4; i++)
+	{
+		if (program.instruction_mask[i])
+		{
+			hasher.update(v128::loadu(instbuffer, i));
+		}
+	}
+
+	return hasher.finalize();
+}
+
 vertex_program_utils::vertex_program_metadata vertex_program_utils::analyse_vertex_program(const u32* data, u32 entry, RSXVertexProgram& dst_prog)
 {
 	vertex_program_utils::vertex_program_metadata result{};
@@ -250,7 +310,7 @@ vertex_program_utils::vertex_program_metadata vertex_program_utils::analyse_vert
 
 usz vertex_program_storage_hash::operator()(const RSXVertexProgram &program) const
 {
-	usz hash = vertex_program_utils::get_vertex_program_ucode_hash(program);
+	usz hash = vertex_program_utils::get_vertex_program_lookup_hash(program);
 	hash ^= program.output_mask;
 	hash ^= program.texture_state.texture_dimensions;
 	return hash;
@@ -447,9 +507,39 @@ usz fragment_program_utils::get_fragment_program_ucode_hash(const RSXFragmentPro
 	return 0;
 }
 
+usz fragment_program_utils::get_fragment_program_lookup_hash(const RSXFragmentProgram& program)
+{
+	if (program.lookup_hash)
+	{
+		return program.lookup_hash;
+	}
+
+	ucode_lookup_hasher hasher;
+	const void* instbuffer = program.get_data();
+	usz instIndex = 0;
+
+	while (true)
+	{
+		const auto inst = v128::loadu(instbuffer, instIndex);
+		hasher.update(inst);
+		instIndex++;
+
+		// Skip constants
+		if (fragment_program_utils::is_constant(inst._u32[1]) ||
+			fragment_program_utils::is_constant(inst._u32[2]) ||
+			fragment_program_utils::is_constant(inst._u32[3]))
+			instIndex++;
+
+		if ((inst._u32[0] >> 8) & 0x1)
+		{
+			return hasher.finalize();
+		}
+	}
+}
+
 usz fragment_program_storage_hash::operator()(const RSXFragmentProgram& program) const
 {
-	usz hash = fragment_program_utils::get_fragment_program_ucode_hash(program);
+	usz hash = fragment_program_utils::get_fragment_program_lookup_hash(program);
 	hash ^= program.ctrl;
 	hash ^= +program.two_sided_lighting;
 	hash ^= program.texture_state.texture_dimensions;
@@ -29,6 +29,9 @@ namespace program_hash_util
 
 		static usz get_vertex_program_ucode_hash(const RSXVertexProgram &program);
 
+		// Faster hash for in-memory lookups. Returns the cached value if set, never persist it
+		static usz get_vertex_program_lookup_hash(const RSXVertexProgram &program);
+
 		static vertex_program_metadata analyse_vertex_program(const u32* data, u32 entry, RSXVertexProgram& dst_prog);
 	};
 
@@ -66,6 +69,9 @@ namespace program_hash_util
 		static fragment_program_metadata analyse_fragment_program(const void* ptr);
 
 		static usz get_fragment_program_ucode_hash(const RSXFragmentProgram &program);
+
+		// Faster hash for in-memory lookups. Returns the cached value if set, never persist it
+		static usz get_fragment_program_lookup_hash(const RSXFragmentProgram &program);
 	};
 
 	struct fragment_program_storage_hash
@@ -155,9 +161,68 @@ protected:
 	fragment_program_type __null_fragment_program;
 	pipeline_storage_type __null_pipeline_handle;
 
+	// Last lookups of the programs tracked by the RSX thread (non-zero ucode generation), only ever touched from that thread.
+	// Consecutive draws mostly reuse the same programs, this skips hashing and comparing the ucode for them
+	struct
+	{
+		u64 ucode_generation = 0;
+		u32 output_mask = 0;
+		rsx::vertex_program_texture_state texture_state;
+		const vertex_program_type* program = nullptr;
+	}
+	m_last_vertex_lookup;
+
+	struct
+	{
+		u64 ucode_generation = 0;
+		u32 ctrl = 0;
+		bool two_sided_lighting = false;
+		rsx::fragment_program_texture_state texture_state;
+		const fragment_program_type* program = nullptr;
+	}
+	m_last_fragment_lookup;
+
+	bool is_last_lookup(const RSXVertexProgram& rsx_vp) const
+	{
+		return rsx_vp.ucode_generation && rsx_vp.skip_vertex_input_check &&
+			rsx_vp.ucode_generation == m_last_vertex_lookup.ucode_generation &&
+			rsx_vp.output_mask == m_last_vertex_lookup.output_mask &&
+			rsx_vp.texture_state == m_last_vertex_lookup.texture_state;
+	}
+
+	bool is_last_lookup(const RSXFragmentProgram& rsx_fp) const
+	{
+		return rsx_fp.ucode_generation &&
+			rsx_fp.ucode_generation == m_last_fragment_lookup.ucode_generation &&
+			rsx_fp.ctrl == m_last_fragment_lookup.ctrl &&
+			rsx_fp.two_sided_lighting == m_last_fragment_lookup.two_sided_lighting &&
+			rsx_fp.texture_state == m_last_fragment_lookup.texture_state;
+	}
+
+	void set_last_lookup(const RSXVertexProgram& rsx_vp, const vertex_program_type& program)
+	{
+		if (rsx_vp.ucode_generation && rsx_vp.skip_vertex_input_check)
+		{
+			m_last_vertex_lookup = { rsx_vp.ucode_generation, rsx_vp.output_mask, rsx_vp.texture_state, &program };
+		}
+	}
+
+	void set_last_lookup(const RSXFragmentProgram& rsx_fp, const fragment_program_type& program)
+	{
+		if (rsx_fp.ucode_generation)
+		{
+			m_last_fragment_lookup = { rsx_fp.ucode_generation, rsx_fp.ctrl, rsx_fp.two_sided_lighting, rsx_fp.texture_state, &program };
+		}
+	}
+
 	/// bool here to inform that the program was preexisting.
 	std::tuple<const vertex_program_type&, bool> search_vertex_program(const RSXVertexProgram& rsx_vp, bool force_load = true)
 	{
+		if (is_last_lookup(rsx_vp))
+		{
+			return std::forward_as_tuple(*m_last_vertex_lookup.program, true);
+		}
+
 		bool recompile = false;
 		vertex_program_type* new_shader;
 		{
@@ -166,6 +231,7 @@ protected:
 			const auto& I = m_vertex_shader_cache.find(rsx_vp);
 			if (I != m_vertex_shader_cache.end())
 			{
+				set_last_lookup(rsx_vp, I->second);
 				return std::forward_as_tuple(I->second, true);
 			}
 
@@ -187,12 +253,19 @@ protected:
 			backend_traits::recompile_vertex_program(rsx_vp, *new_shader, m_next_id++);
 		}
 
+		set_last_lookup(rsx_vp, *new_shader);
+
 		return std::forward_as_tuple(*new_shader, false);
 	}
 
 	/// bool here to inform that the program was preexisting.
 	std::tuple<const fragment_program_type&, bool> search_fragment_program(const RSXFragmentProgram& rsx_fp, bool force_load = true)
 	{
+		if (is_last_lookup(rsx_fp))
+		{
+			return std::forward_as_tuple(*m_last_fragment_lookup.program, true);
+		}
+
 		bool recompile = false;
 		typename binary_to_fragment_program::iterator it;
 		fragment_program_type* new_shader;
@@ -203,6 +276,7 @@ protected:
 			const auto& I = m_fragment_shader_cache.find(rsx_fp);
 			if (I != m_fragment_shader_cache.end())
 			{
+				set_last_lookup(rsx_fp, I->second);
 				return std::forward_as_tuple(I->second, true);
 			}
 
@@ -224,6 +298,8 @@ protected:
 			backend_traits::recompile_fragment_program(rsx_fp, *new_shader, m_next_id++);
 		}
 
+		set_last_lookup(rsx_fp, *new_shader);
+
 		return std::forward_as_tuple(*new_shader, false);
 	}
 
@@ -408,5 +484,8 @@ public:
 		m_fragment_shader_cache.clear();
 		m_vertex_shader_cache.clear();
 		m_storage.clear();
+
+		m_last_vertex_lookup = {};
+		m_last_fragment_lookup = {};
 	}
 };
@@ -308,6 +308,10 @@ struct RSXFragmentProgram
 
 	bool valid = false;
 
+	// Set by the RSX thread each time the ucode is analysed. Programs with the same non-zero generation have identical ucode
+	u64 ucode_generation = 0;
+	usz lookup_hash = 0; // Cached get_fragment_program_lookup_hash, 0 if not computed
+
 	rsx::texture_dimension_extended get_texture_dimension(u8 id) const
 	{
 		return rsx::texture_dimension_extended{static_cast<u8>((texture_state.texture_dimensions >> (id * 2)) & 0x3)};
@@ -0,0 +1,200 @@
+#include "stdafx.h"
+#include "decompiled_program_cache.h"
+#include "ProgramStateCache.h"
+
+#include "Emu/RSX/rsx_utils.h"
+#include "util/fnv_hash.hpp"
+#include "util/serialization.hpp"
+#include "util/v128.hpp"
+
+namespace rsx
+{
+	decompiled_program_cache_t decompiled_program_cache;
+
+	bool decompiled_program_cache_t::open(const std::string& path)
+	{
+		std::lock_guard lock(m_mutex);
+
+		m_hits = 0;
+		m_misses = 0;
+
+		// The file only holds program records, the pipeline record size is irrelevant
+		return m_file.open(path, 0);
+	}
+
+	void decompiled_program_cache_t::close()
+	{
+		std::lock_guard lock(m_mutex);
+
+		if (m_file)
+		{
+			rsx_log.notice("Decompiled program cache: %u hits, %u misses", m_hits.load(), m_misses.load());
+		}
+
+		m_file.close();
+	}
+
+	u64 decompiled_program_cache_t::get_key(std::span<const u8> signature)
+	{
+		u64 key = rpcs3::fnv_seed;
+		usz offset = 0;
+
+		for (; offset + 8 <= signature.size(); offset += 8)
+		{
+			u64 value;
+			std::memcpy(&value, signature.data() + offset, sizeof(u64));
+			key = rpcs3::hash64(key, value);
+		}
+
+		for (; offset < signature.size(); ++offset)
+		{
+			key = rpcs3::hash64(key, signature[offset]);
+		}
+
+		return key;
+	}
+
+	std::vector<u8> decompiled_program_cache_t::get_signature(const RSXVertexProgram& prog, std::span<const u8> backend_state)
+	{
+		utils::serial ar;
+		ar.reserve(backend_state.size() + prog.data.size() * sizeof(u32) + 64);
+		ar.raw_serialize(backend_state.data(), backend_state.size());
+
+		// Everything the decompiler reads from the program. The vertex inputs are not part of it, they are bound at draw time
+		ar(prog.output_mask, prog.texture_state.texture_dimensions, prog.entry - prog.base_address, prog.jump_table, ::size32(prog.data));
+
+		for (u32 i = 0; i < prog.data.size() / 4; ++i)
+		{
+			if (prog.instruction_mask[i])
+			{
+				ar(i);
+				ar.raw_serialize(prog.data.data() + i * 4, sizeof(u32) * 4);
+			}
+		}
+
+		return std::move(ar.data);
+	}
+
+	std::vector<u8> decompiled_program_cache_t::get_signature(const RSXFragmentProgram& prog, std::span<const u8> backend_state)
+	{
+		utils::serial ar;
+		ar.reserve(backend_state.size() + prog.ucode_length + 64);
+		ar.raw_serialize(backend_state.data(), backend_state.size());
+
+		ar(prog.ctrl, prog.two_sided_lighting, prog.texcoord_control_mask,
+			prog.texture_state.texture_dimensions, prog.texture_state.unnormalized_coords,
+			prog.texture_state.redirected_textures, prog.texture_state.shadow_textures);
+
+		// Same walk as the ucode hash, constants are read from the constant buffer and do not affect the source
+		const void* instbuffer = prog.get_data();
+		usz index = 0;
+
+		while (true)
+		{
+			const auto inst = v128::loadu(instbuffer, index);
+			ar.raw_serialize(&inst, sizeof(inst));
+			index++;
+
+			if (program_hash_util::fragment_program_utils::is_constant(inst._u32[1]) ||
+				program_hash_util::fragment_program_utils::is_constant(inst._u32[2]) ||
+				program_hash_util::fragment_program_utils::is_constant(inst._u32[3]))
+			{
+				index++;
+			}
+
+			if ((inst._u32[0] >> 8) & 0x1)
+			{
+				break;
+			}
+		}
+
+		return std::move(ar.data);
+	}
+
+	bool decompiled_program_cache_t::find(record_type type, const std::vector<u8>& signature, entry& result) const
+	{
+		reader_lock lock(m_mutex);
+
+		const auto record = m_file.find(type, get_key(signature));
+		if (record.size() < sizeof(record_header))
+		{
+			m_misses++;
+			return false;
+		}
+
+		record_header header{};
+		std::memcpy(&header, record.data(), sizeof(record_header));
+
+		const usz payload_size = usz{header.signature_size} + header.source_size + header.metadata_size;
+		const u8* signature_data = record.data() + sizeof(record_header);
+
+		if (sizeof(record_header) + payload_size != record.size() || header.signature_size != signature.size() ||
+			std::memcmp(signature_data, signature.data(), signature.size()) != 0)
+		{
+			// Key collision or a stale entry
+			m_misses++;
+			return false;
+		}
+
+		const u8* source_data = signature_data + header.signature_size;
+		const u8* metadata_data = source_data + header.source_size;
+
+		result.source.assign(reinterpret_cast<const char*>(source_data), header.source_size);
+		result.metadata.assign(metadata_data, metadata_data + header.metadata_size);
+
+		m_hits++;
+		return true;
+	}
+
+	void decompiled_program_cache_t::store(record_type type, const std::vector<u8>& signature, const entry& data)
+	{
+		reader_lock lock(m_mutex);
+
+		if (!m_file)
+		{
+			return;
+		}
+
+		const record_header header{ ::size32(signature), ::size32(data.source), ::size32(data.metadata), 0 };
+		const usz record_size = sizeof(record_header) + signature.size() + data.source.size() + data.metadata.size();
+
+		if (record_size > pipeline_cache_file::max_record_size)
+		{
+			return;
+		}
+
+		std::vector<u8> record(record_size);
+		u8* dst = record.data();
+
+		std::memcpy(dst, &header, sizeof(record_header));
+		dst += sizeof(record_header);
+		std::memcpy(dst, signature.data(), signature.size());
+		dst += signature.size();
+		std::memcpy(dst, data.source.data(), data.source.size());
+		dst += data.source.size();
+		std::memcpy(dst, data.metadata.data(), data.metadata.size());
+
+		// Collisions keep the first entry, the signature check turns them into misses
+		m_file.append(type, get_key(signature), record.data(), ::size32(record));
+	}
+
+	bool decompiled_program_cache_t::find(const RSXVertexProgram& prog, std::span<const u8> backend_state, entry& result) const
+	{
+		return find(record_type::vertex_program, get_signature(prog, backend_state), result);
+	}
+
+	bool decompiled_program_cache_t::find(const RSXFragmentProgram& prog, std::span<const u8> backend_state, entry& result) const
+	{
+		return find(record_type::fragment_program, get_signature(prog, backend_state), result);
+	}
+
+	void decompiled_program_cache_t::store(const RSXVertexProgram& prog, std::span<const u8> backend_state, const entry& data)
+	{
+		store(record_type::vertex_program, get_signature(prog, backend_state), data);
+	}
+
+	void decompiled_program_cache_t::store(const RSXFragmentProgram& prog, std::span<const u8> backend_state, const entry& data)
+	{
+		store(record_type::fragment_program, get_signature(prog, backend_state), data);
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "RSXFragmentProgram.h"
+#include "RSXVertexProgram.h"
+#include "../Common/pipeline_cache_file.h"
+
+#include "Utilities/mutex.h"
+#include "util/atomic.hpp"
+
+#include <span>
+#include <string>
+#include <vector>
+
+namespace rsx
+{
+	/**
+	 * On-disk cache of the shader source generated by the program decompilers.
+	 * Entries are keyed on the program ucode and on every piece of program state read by the decompilers, plus a blob of
+	 * backend state (device capabilities, binding layout) which also ends up in the generated source.
+	 * Backends store the rest of their decompiler output (constant offsets, resource bindings) next to the source
+	 * so that a hit skips the decompiler entirely.
+	 */
+	class decompiled_program_cache_t
+	{
+	public:
+		struct entry
+		{
+			std::string source;
+			std::vector<u8> metadata; // Backend defined
+		};
+
+	private:
+		using record_type = pipeline_cache_file::record_type;
+
+		struct record_header
+		{
+			u32 signature_size;
+			u32 source_size;
+			u32 metadata_size;
+			u32 reserved;
+		};
+
+		pipeline_cache_file m_file;
+		mutable shared_mutex m_mutex;
+
+		mutable atomic_t<u32> m_hits = 0;
+		mutable atomic_t<u32> m_misses = 0;
+
+		static u64 get_key(std::span<const u8> signature);
+
+		bool find(record_type type, const std::vector<u8>& signature, entry& result) const;
+		void store(record_type type, const std::vector<u8>& signature, const entry& data);
+
+	public:
+		// Opening a new file closes the previous one
+		bool open(const std::string& path);
+		void close();
+
+		// Serialized decompiler inputs, the exact bytes the cache entries are matched against
+		static std::vector<u8> get_signature(const RSXVertexProgram& prog, std::span<const u8> backend_state);
+		static std::vector<u8> get_signature(const RSXFragmentProgram& prog, std::span<const u8> backend_state);
+
+		// Only entries present when the file was opened are visible, new entries are written to disk for the next run
+		bool find(const RSXVertexProgram& prog, std::span<const u8> backend_state, entry& result) const;
+		bool find(const RSXFragmentProgram& prog, std::span<const u8> backend_state, entry& result) const;
+
+		void store(const RSXVertexProgram& prog, std::span<const u8> backend_state, const entry& data);
+		void store(const RSXFragmentProgram& prog, std::span<const u8> backend_state, const entry& data);
+	};
+
+	extern decompiled_program_cache_t decompiled_program_cache;
+}
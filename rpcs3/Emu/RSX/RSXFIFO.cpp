@@ -4,6 +4,7 @@
 #include "RSXThread.h"
 #include "Capture/rsx_capture.h"
 #include "Emu/Cell/lv2/sys_rsx.h"
+#include "Emu/perf_meter.hpp"
 
 namespace rsx
 {
@@ -71,23 +72,48 @@ namespace rsx
 			// Update ctrl registers
 			m_ctrl->get.release(m_internal_get = get);
 			m_remaining_commands = 0;
+			reset_prefetch();
 
 			// Clear memwatch spinner
 			m_memwatch_addr = 0;
 		}
 
+		bool FIFO_control::prefetch_args(u32 put)
+		{
+			// NOTE: The pending arguments start right after m_args_ptr, m_internal_get points at the first of them
+			// If PUT is behind us the stream is wrapping around through a jump placed after this packet,
+			// don't read past the current IO page then (the next one may not be mapped contiguously)
+			const u32 available = put >= m_internal_get ? (put - m_internal_get) / 4 : (0x100000 - (m_internal_get & 0xfffff)) / 4;
+			const u32 count = std::min({ available, m_remaining_commands, prefetch_buffer_size });
+
+			if (!count)
+			{
+				return false;
+			}
+
+			const auto src = vm::_ptr<const be_t<u32>>(m_args_ptr + 4);
+			for (u32 i = 0; i < count; ++i)
+			{
+				m_prefetch_buffer[i] = src[i];
+			}
+
+			m_prefetch_index = 0;
+			m_prefetch_count = count;
+			return true;
+		}
+
 		bool FIFO_control::read_unsafe(register_pair& data)
 		{
 			// Fast read with no processing, only safe inside a PACKET_BEGIN+count block
-			if (m_remaining_commands &&
-				m_internal_get != read_put<false>())
+			if (m_prefetch_index < m_prefetch_count ||
+				(m_remaining_commands && prefetch_args(read_put<false>())))
 			{
 				m_command_reg += m_command_inc;
 				m_args_ptr += 4;
 				m_remaining_commands--;
 				m_internal_get += 4;
 
-				data.set(m_command_reg, vm::read32(m_args_ptr));
+				data.set(m_command_reg, m_prefetch_buffer[m_prefetch_index++]);
 				return true;
 			}
 
@@ -105,17 +131,28 @@ namespace rsx
 				m_remaining_commands -= count;
 				m_internal_get += 4 * count;
 
+				if (count < m_prefetch_count - m_prefetch_index)
+				{
+					m_prefetch_index += count;
+				}
+				else
+				{
+					reset_prefetch();
+				}
+
 				return true;
 			}
 
 			m_internal_get += 4 * m_remaining_commands;
 			m_remaining_commands = 0;
+			reset_prefetch();
 			return false;
 		}
 
 		void FIFO_control::abort()
 		{
 			m_remaining_commands = 0;
+			reset_prefetch();
 		}
 
 		void FIFO_control::read(register_pair& data)
@@ -208,6 +245,7 @@ namespace rsx
 				m_command_reg = m_cmd & 0xfffc;
 				m_command_inc = ((m_cmd & RSX_METHOD_NON_INCREMENT_CMD_MASK) == RSX_METHOD_NON_INCREMENT_CMD) ? 0 : 4;
 				m_remaining_commands = count - 1;
+				reset_prefetch();
 			}
 
 			inc_get(true); // Wait for data block to become available
@@ -621,7 +659,16 @@ namespace rsx
 
 			if (auto method = methods[reg])
 			{
-				method(this, reg, value);
+				if (m_method_profiler.enabled()) [[unlikely]]
+				{
+					const u64 start = get_tsc();
+					method(this, reg, value);
+					m_method_profiler.record(reg, start, get_tsc());
+				}
+				else
+				{
+					method(this, reg, value);
+				}
 			}
 		}
 		while (fifo_ctrl->read_unsafe(command));
@@ -124,6 +124,16 @@ namespace rsx
 			u32 m_args_ptr = 0;
 			u32 m_cmd = ~0u;
 
+			// Host copy of the upcoming arguments of the current packet, fetched in bulk up to the last observed PUT
+			// This avoids touching the PUT register and guest memory for every single argument of long packets
+			static constexpr u32 prefetch_buffer_size = 256;
+			std::array<u32, prefetch_buffer_size> m_prefetch_buffer;
+			u32 m_prefetch_index = 0;
+			u32 m_prefetch_count = 0;
+
+			bool prefetch_args(u32 put);
+			void reset_prefetch() { m_prefetch_index = m_prefetch_count = 0; }
+
 		public:
 			FIFO_control(rsx::thread* pctrl);
 			~FIFO_control() = default;
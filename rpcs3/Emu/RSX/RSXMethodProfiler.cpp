@@ -0,0 +1,230 @@
+#include "stdafx.h"
+#include "RSXMethodProfiler.h"
+
+#include "gcm_printing.h"
+#include "rsx_utils.h"
+#include "Emu/system_config.h"
+#include "Utilities/File.h"
+#include "util/sysinfo.hpp"
+
+#include <algorithm>
+
+namespace rsx
+{
+	static std::string get_profiled_name(u32 id)
+	{
+		switch (id)
+		{
+		case method_profiler::phase_draw_begin: return "Draw begin";
+		case method_profiler::phase_draw_end: return "Draw end";
+		default: return get_method_name(id);
+		}
+	}
+
+	// Flushes the string to the file once it grows past the threshold
+	static bool flush_to_file(fs::file& file, std::string& data, usz threshold)
+	{
+		if (data.size() < threshold)
+		{
+			return true;
+		}
+
+		const bool result = file.write(data.data(), data.size()) == data.size();
+		data.clear();
+		return result;
+	}
+
+	void method_profiler::init()
+	{
+		const method_profiling_mode mode = g_cfg.video.method_profiling;
+
+		m_enabled = mode != method_profiling_mode::disabled;
+		m_trace_enabled = mode == method_profiling_mode::trace;
+
+		m_stats.clear();
+		m_trace.clear();
+
+		if (m_enabled)
+		{
+			m_stats.resize(phase_count);
+		}
+
+		if (m_trace_enabled)
+		{
+			m_trace.reserve(max_trace_events / 8);
+		}
+	}
+
+	void method_profiler::report() const
+	{
+		if (!m_enabled)
+		{
+			return;
+		}
+
+		write_report();
+		write_trace();
+	}
+
+	void method_profiler::write_report() const
+	{
+		const u64 tsc_freq = utils::get_tsc_freq();
+
+		if (!tsc_freq)
+		{
+			rsx_log.warning("RSX method profiler: TSC frequency is unknown, durations are reported in ticks");
+		}
+
+		// Nanoseconds per tick, or ticks when the frequency is unknown
+		const f64 scale = tsc_freq ? 1'000'000'000. / tsc_freq : 1.;
+
+		std::vector<u32> ids;
+		u64 total_ticks = 0;
+
+		for (u32 id = 0; id < ::size32(m_stats); id++)
+		{
+			if (m_stats[id])
+			{
+				ids.push_back(id);
+
+				// Draw phases run inside NV4097_SET_BEGIN_END and are not counted twice
+				if (id < phase_draw_begin)
+				{
+					total_ticks += m_stats[id]->total;
+				}
+			}
+		}
+
+		if (ids.empty())
+		{
+			rsx_log.notice("RSX method profiler: No methods were executed");
+			return;
+		}
+
+		std::sort(ids.begin(), ids.end(), [&](u32 a, u32 b)
+		{
+			return m_stats[a]->total > m_stats[b]->total;
+		});
+
+		// Upper bound of the histogram bucket containing the given fraction of the calls
+		const auto percentile = [&](const method_stats& stats, f64 fraction) -> f64
+		{
+			const u64 target = static_cast<u64>(std::ceil(stats.count * fraction));
+			u64 seen = 0;
+
+			for (u32 bucket = 0; bucket < stats.histogram.size(); bucket++)
+			{
+				seen += stats.histogram[bucket];
+
+				if (seen >= target)
+				{
+					const u64 upper = bucket >= 64 ? umax : (1ull << bucket) - 1;
+					return std::min<u64>(upper, stats.max) * scale;
+				}
+			}
+
+			return stats.max * scale;
+		};
+
+		std::string report = fmt::format("RSX method profile, %s per call\n", tsc_freq ? "times in ns" : "times in ticks");
+		fmt::append(report, "%-64s %12s %12s %7s %10s %10s %10s %10s %10s\n", "Method", "Calls", "Total (ms)", "Share", "Avg", "Min", "P50", "P99", "Max");
+
+		for (const u32 id : ids)
+		{
+			const auto& stats = *m_stats[id];
+			const f64 share = total_ticks ? stats.total * 100. / total_ticks : 0.;
+			const f64 total_ms = stats.total * scale / 1'000'000.;
+
+			fmt::append(report, "%-64s %12u %12.3f %6.2f%% %10.0f %10.0f %10.0f %10.0f %10.0f\n",
+				get_profiled_name(id), stats.count, total_ms, share,
+				stats.total * scale / stats.count, stats.min * scale,
+				percentile(stats, 0.5), percentile(stats, 0.99), stats.max * scale);
+		}
+
+		const std::string path = fs::get_cache_dir() + "rsx_method_profile.txt";
+
+		if (fs::file file{ path, fs::rewrite }; file && file.write(report.data(), report.size()) == report.size())
+		{
+			rsx_log.notice("RSX method profile written to '%s'", path);
+		}
+		else
+		{
+			rsx_log.error("Failed to write RSX method profile to '%s' (%s)", path, fs::g_tls_error);
+		}
+
+		// Log the heaviest methods
+		constexpr usz logged_count = 16;
+
+		for (usz i = 0; i < std::min(logged_count, ids.size()); i++)
+		{
+			const auto& stats = *m_stats[ids[i]];
+			rsx_log.notice("RSX method profile: %s: %u calls, %.3fms (%.2f%%)", get_profiled_name(ids[i]), stats.count,
+				stats.total * scale / 1'000'000., total_ticks ? stats.total * 100. / total_ticks : 0.);
+		}
+	}
+
+	void method_profiler::write_trace() const
+	{
+		if (m_trace.empty())
+		{
+			return;
+		}
+
+		if (m_trace.size() >= max_trace_events)
+		{
+			rsx_log.warning("RSX method trace is truncated to the first %u events", max_trace_events);
+		}
+
+		const std::string path = fs::get_cache_dir() + "rsx_method_trace.json";
+		fs::file file(path, fs::rewrite);
+
+		if (!file)
+		{
+			rsx_log.error("Failed to create RSX method trace '%s' (%s)", path, fs::g_tls_error);
+			return;
+		}
+
+		const u64 tsc_freq = utils::get_tsc_freq();
+
+		// Trace timestamps are in microseconds
+		const f64 scale = tsc_freq ? 1'000'000. / tsc_freq : 0.001;
+		const u64 base = std::min_element(m_trace.begin(), m_trace.end(), [](const trace_event& a, const trace_event& b)
+		{
+			// Nested events are recorded after they end, before the event containing them
+			return a.start < b.start;
+		})->start;
+
+		std::vector<std::string> names(phase_count);
+		std::string data = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+		bool ok = true;
+
+		for (usz i = 0; i < m_trace.size() && ok; i++)
+		{
+			const auto& event = m_trace[i];
+			auto& name = names[event.id];
+
+			if (name.empty())
+			{
+				name = get_profiled_name(event.id);
+			}
+
+			fmt::append(data, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+				i ? ",\n" : "", name, event.id >= phase_draw_begin ? "draw" : "method",
+				(event.start - base) * scale, (event.end - event.start) * scale);
+
+			ok = flush_to_file(file, data, 0x100000);
+		}
+
+		data += "\n]}\n";
+		ok = ok && flush_to_file(file, data, 0);
+
+		if (ok)
+		{
+			rsx_log.notice("RSX method trace (%u events) written to '%s'", m_trace.size(), path);
+		}
+		else
+		{
+			rsx_log.error("Failed to write RSX method trace to '%s'", path);
+		}
+	}
+}
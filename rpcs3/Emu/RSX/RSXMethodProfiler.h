@@ -0,0 +1,95 @@
+#pragma once
+
+#include "util/types.hpp"
+
+#include <array>
+#include <bit>
+#include <memory>
+#include <vector>
+
+namespace rsx
+{
+	// Per-method timing of the RSX thread, sampled with the TSC around each method handler and draw phase.
+	// The results are reported when the RSX thread exits.
+	class method_profiler
+	{
+	public:
+		// Draw phases are recorded as pseudo-registers following the method registers
+		enum phase : u32
+		{
+			phase_draw_begin = 0x10000 >> 2,
+			phase_draw_end,
+
+			phase_count
+		};
+
+		struct method_stats
+		{
+			u64 count = 0;
+			u64 total = 0; // TSC ticks
+			u64 min = umax;
+			u64 max = 0;
+			std::array<u64, 65> histogram{}; // Indexed by the bit width of the duration in ticks
+		};
+
+		// Upper limit of the trace, recording stops once it is reached
+		static constexpr usz max_trace_events = 2'000'000;
+
+	private:
+		struct trace_event
+		{
+			u64 start;
+			u64 end;
+			u32 id;
+		};
+
+		std::vector<std::unique_ptr<method_stats>> m_stats;
+		std::vector<trace_event> m_trace;
+		bool m_enabled = false;
+		bool m_trace_enabled = false;
+
+		void write_report() const;
+		void write_trace() const;
+
+	public:
+		// Reads the configuration and discards previous results
+		void init();
+
+		bool enabled() const
+		{
+			return m_enabled;
+		}
+
+		void record(u32 id, u64 start, u64 end)
+		{
+			auto& stats = m_stats[id];
+
+			if (!stats) [[unlikely]]
+			{
+				stats = std::make_unique<method_stats>();
+			}
+
+			const u64 duration = end - start;
+			stats->count++;
+			stats->total += duration;
+			stats->min = std::min(stats->min, duration);
+			stats->max = std::max(stats->max, duration);
+			stats->histogram[64 - std::countl_zero(duration)]++;
+
+			if (m_trace_enabled)
+			{
+				if (m_trace.size() < max_trace_events) [[likely]]
+				{
+					m_trace.push_back({ start, end, id });
+				}
+				else
+				{
+					m_trace_enabled = false;
+				}
+			}
+		}
+
+		// Writes the sorted report to the log and the cache directory, and exports the trace if one was recorded
+		void report() const;
+	};
+}
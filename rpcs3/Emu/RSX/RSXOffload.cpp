@@ -5,93 +5,420 @@
 #include "RSXThread.h"
 #include "rsx_utils.h"
 
+#include <array>
+#include <deque>
 #include <thread>
 #include "util/asm.hpp"
+#include "util/sysinfo.hpp"
 
 namespace rsx
 {
 	struct dma_manager::offload_thread
 	{
+		// Packets from the RSX thread go through a single producer, single consumer ring of preallocated slots.
+		// Other threads are rare producers and use the lock-free list of the first worker instead.
+		static constexpr u32 ring_size = 1024;
+
+		// Idle iterations before the worker goes to sleep, the producer only signals a sleeping worker
+		static constexpr u32 spin_count = 64;
+
+		struct ring_entry
+		{
+			transport_packet packet;
+
+			// Ring positions the other workers must have retired before this packet may run
+			u32 dependency_mask = 0;
+			std::array<u64, max_offload_threads> dependencies{};
+		};
+
+		std::unique_ptr<ring_entry[]> m_ring = std::make_unique<ring_entry[]>(ring_size);
+		alignas(64) atomic_t<u64> m_ring_put = 0;
+		u64 m_ring_get_cached = 0;
+		alignas(64) atomic_t<u64> m_ring_get = 0;
+
 		lf_queue<transport_packet> m_work_queue;
-		atomic_t<u64> m_enqueued_count = 0;
+		alignas(64) atomic_t<u64> m_enqueued_count = 0;
 		atomic_t<u64> m_processed_count = 0;
+		atomic_t<bool> m_sleeping = false;
 		transport_packet* m_current_job = nullptr;
 
-		std::thread::id m_thread_id;
+		// Returns the ring position of the packet, packets from other threads return 0
+		template <typename... Args>
+		u64 enqueue(const std::array<u64, max_offload_threads>& dependencies, u32 dependency_mask, Args&&... args);
 
-		void operator ()()
+		void wake()
 		{
-			if (!g_cfg.video.multithreaded_rsx)
+			m_sleeping.release(false);
+			m_enqueued_count.notify_one();
+		}
+
+		void process(transport_packet& job);
+		void operator ()();
+
+		static constexpr auto thread_name = "RSX Offloader"sv;
+	};
+
+	using dma_thread = named_thread<dma_manager::offload_thread>;
+
+	struct dma_manager::offload_pool
+	{
+		// Host memory touched by a packet still in flight. Only accessed by the RSX thread
+		struct tracked_packet
+		{
+			uptr write_start;
+			uptr write_end;
+			uptr read_start;
+			uptr read_end;
+			u64 ring_position;
+			u32 worker;
+			bool barrier;
+
+			bool conflicts_with(const tracked_packet& other) const
 			{
-				// Abort if disabled
-				return;
+				if (barrier || other.barrier)
+				{
+					return true;
+				}
+
+				const auto overlaps = [](uptr start0, uptr end0, uptr start1, uptr end1)
+				{
+					return start0 < end1 && start1 < end0;
+				};
+
+				return overlaps(write_start, write_end, other.write_start, other.write_end) ||
+					overlaps(write_start, write_end, other.read_start, other.read_end) ||
+					overlaps(read_start, read_end, other.write_start, other.write_end);
 			}
+		};
+
+		std::vector<std::unique_ptr<dma_thread>> workers;
+		atomic_t<u64> m_enqueued_count = 0;
+		atomic_t<u64> m_processed_count = 0;
+
+		// Packets in flight per worker, in ring order
+		std::array<std::deque<tracked_packet>, max_offload_threads> m_in_flight;
+		u32 m_next_worker = 0;
 
-			m_thread_id = std::this_thread::get_id();
+		// Only the newest packets of a worker are checked for conflicts, the older ones are depended on as a whole
+		static constexpr usz max_conflict_scan = 64;
 
-			if (g_cfg.core.thread_scheduler != thread_scheduler_mode::os)
+		bool is_retired(const tracked_packet& packet) const
+		{
+			return workers[packet.worker]->m_ring_get >= packet.ring_position;
+		}
+
+		void retire_completed()
+		{
+			for (u32 i = 0; i < ::size32(workers); i++)
 			{
-				thread_ctrl::set_thread_affinity_mask(thread_ctrl::get_affinity_mask(thread_class::rsx));
+				auto& queue = m_in_flight[i];
+
+				if (queue.empty())
+				{
+					continue;
+				}
+
+				// Workers retire their packets in order
+				const u64 get = workers[i]->m_ring_get;
+
+				while (!queue.empty() && queue.front().ring_position <= get)
+				{
+					queue.pop_front();
+				}
 			}
+		}
 
-			while (thread_ctrl::state() != thread_state::aborting)
+		template <typename... Args>
+		void dispatch(tracked_packet info, Args&&... args)
+		{
+			if (!get_current_renderer()->is_current_thread()) [[unlikely]]
 			{
-				for (auto&& job : m_work_queue.pop_all())
-				{
-					m_current_job = &job;
+				// Not ordered against the RSX thread's packets, same as with a single worker
+				m_enqueued_count++;
+				workers[0]->enqueue({}, 0, std::forward<Args>(args)...);
+				return;
+			}
 
-					switch (job.type)
-					{
-					case raw_copy:
+			retire_completed();
+
+			std::array<u64, max_offload_threads> dependencies{};
+			u32 dependency_mask = 0;
+			u32 conflict_mask = 0;
+
+			for (u32 i = 0; i < ::size32(workers); i++)
+			{
+				const auto& queue = m_in_flight[i];
+				usz scanned = 0;
+
+				// Newest first, depending on a packet covers the older ones of the same worker
+				for (auto it = queue.rbegin(); it != queue.rend(); ++it, ++scanned)
+				{
+					if (scanned == max_conflict_scan)
 					{
-						std::memcpy(job.dst, job.src, job.length);
+						dependencies[i] = it->ring_position;
+						dependency_mask |= (1u << i);
 						break;
 					}
-					case vector_copy:
+
+					if (it->conflicts_with(info))
 					{
-						std::memcpy(job.dst, job.opt_storage.data(), job.length);
+						dependencies[i] = it->ring_position;
+						dependency_mask |= (1u << i);
+						conflict_mask |= (1u << i);
 						break;
 					}
-					case index_emulate:
+				}
+			}
+
+			if (info.barrier)
+			{
+				// Renderer callbacks always run on the first worker
+				info.worker = 0;
+			}
+			else if (conflict_mask)
+			{
+				// Queue behind one of the packets it conflicts with, the worker's own order covers that dependency
+				info.worker = std::countr_zero(conflict_mask);
+			}
+			else
+			{
+				info.worker = m_next_worker;
+				m_next_worker = (m_next_worker + 1) % ::size32(workers);
+			}
+
+			dependency_mask &= ~(1u << info.worker);
+
+			m_enqueued_count++;
+			info.ring_position = workers[info.worker]->enqueue(dependencies, dependency_mask, std::forward<Args>(args)...);
+			m_in_flight[info.worker].push_back(info);
+		}
+	};
+
+	static_assert(std::is_default_constructible_v<dma_manager::offload_pool>);
+
+	// Set on the offload worker threads
+	thread_local dma_manager::offload_thread* g_tls_offload_worker = nullptr;
+
+	template <typename... Args>
+	u64 dma_manager::offload_thread::enqueue(const std::array<u64, max_offload_threads>& dependencies, u32 dependency_mask, Args&&... args)
+	{
+		u64 position = 0;
+
+		m_enqueued_count++;
+
+		if (get_current_renderer()->is_current_thread()) [[likely]]
+		{
+			const u64 put = m_ring_put;
+
+			if (put - m_ring_get_cached >= ring_size) [[unlikely]]
+			{
+				// Ring is full, let the worker catch up
+				while (put - (m_ring_get_cached = m_ring_get.load()) >= ring_size)
+				{
+					std::this_thread::yield();
+				}
+			}
+
+			auto& entry = m_ring[put % ring_size];
+			entry.packet = transport_packet(std::forward<Args>(args)...);
+			entry.dependency_mask = dependency_mask;
+			entry.dependencies = dependencies;
+
+			position = put + 1;
+			m_ring_put.release(position);
+		}
+		else
+		{
+			m_work_queue.push(std::forward<Args>(args)...);
+		}
+
+		if (m_sleeping) [[unlikely]]
+		{
+			wake();
+		}
+
+		return position;
+	}
+
+	void dma_manager::offload_thread::process(transport_packet& job)
+	{
+		m_current_job = &job;
+
+		switch (job.type)
+		{
+		case raw_copy:
+		{
+			std::memcpy(job.dst, job.src, job.length);
+			break;
+		}
+		case vector_copy:
+		{
+			std::memcpy(job.dst, job.opt_storage.data(), job.length);
+			break;
+		}
+		case index_emulate:
+		{
+			write_index_array_for_non_indexed_non_native_primitive_to_buffer(static_cast<char*>(job.dst), static_cast<rsx::primitive_type>(job.aux_param0), job.length);
+			break;
+		}
+		case callback:
+		{
+			rsx::get_current_renderer()->renderctl(job.aux_param0, job.src);
+			break;
+		}
+		default: fmt::throw_exception("Unreachable");
+		}
+
+		m_current_job = nullptr;
+		m_processed_count.release(m_processed_count + 1);
+		g_fxo->get<offload_pool>().m_processed_count++;
+	}
+
+	void dma_manager::offload_thread::operator()()
+	{
+		g_tls_offload_worker = this;
+
+		if (g_cfg.core.thread_scheduler != thread_scheduler_mode::os)
+		{
+			thread_ctrl::set_thread_affinity_mask(thread_ctrl::get_affinity_mask(thread_class::rsx));
+		}
+
+		const auto& pool = g_fxo->get<offload_pool>();
+		u32 idle_count = 0;
+
+		const auto wait_for_dependencies = [&](const ring_entry& entry)
+		{
+			for (u32 mask = entry.dependency_mask; mask; mask &= mask - 1)
+			{
+				const u32 worker = std::countr_zero(mask);
+
+				while (pool.workers[worker]->m_ring_get < entry.dependencies[worker])
+				{
+					if (thread_ctrl::state() == thread_state::aborting)
 					{
-						write_index_array_for_non_indexed_non_native_primitive_to_buffer(static_cast<char*>(job.dst), static_cast<rsx::primitive_type>(job.aux_param0), job.length);
-						break;
+						return false;
 					}
-					case callback:
+
+					std::this_thread::yield();
+				}
+			}
+
+			return true;
+		};
+
+		while (thread_ctrl::state() != thread_state::aborting)
+		{
+			bool busy = false;
+
+			for (u64 get = m_ring_get, put = m_ring_put.load(); get != put; put = m_ring_put.load())
+			{
+				// Drain the whole batch, each slot is released as soon as it is retired
+				for (; get != put; get++)
+				{
+					auto& entry = m_ring[get % ring_size];
+
+					if (!wait_for_dependencies(entry))
 					{
-						rsx::get_current_renderer()->renderctl(job.aux_param0, job.src);
 						break;
 					}
-					default: fmt::throw_exception("Unreachable");
+
+					process(entry.packet);
+
+					if (entry.packet.type == vector_copy)
+					{
+						entry.packet.opt_storage = {};
 					}
 
-					m_processed_count.release(m_processed_count + 1);
+					m_ring_get.release(get + 1);
 				}
 
-				m_current_job = nullptr;
+				busy = true;
 
-				if (m_enqueued_count.load() == m_processed_count.load())
+				if (get != put)
 				{
-					m_processed_count.notify_all();
-					std::this_thread::yield();
+					// Aborting
+					break;
 				}
 			}
 
-			m_processed_count = -1;
-			m_processed_count.notify_all();
-		}
+			for (auto&& job : m_work_queue.pop_all())
+			{
+				process(job);
+				busy = true;
+			}
 
-		static constexpr auto thread_name = "RSX Offloader"sv;
-	};
+			if (busy)
+			{
+				idle_count = 0;
+				continue;
+			}
 
+			if (++idle_count < spin_count)
+			{
+				std::this_thread::yield();
+				continue;
+			}
 
-	using dma_thread = named_thread<dma_manager::offload_thread>;
+			// Sleep until the next packet, the producer checks the flag after publishing its packet
+			m_sleeping = true;
 
-	static_assert(std::is_default_constructible_v<dma_thread>);
+			if (const u64 enqueued = m_enqueued_count.load(); enqueued == m_processed_count.load())
+			{
+				thread_ctrl::wait_on(m_enqueued_count, enqueued);
+			}
+
+			m_sleeping = false;
+			idle_count = 0;
+		}
+
+		g_tls_offload_worker = nullptr;
+	}
 
 	// initialization
 	void dma_manager::init()
 	{
+		auto& pool = g_fxo->get<offload_pool>();
+
+		if (!g_cfg.video.multithreaded_rsx || !pool.workers.empty())
+		{
+			return;
+		}
+
+		u32 num_workers = g_cfg.video.offload_threads_count;
+
+		if (!num_workers)
+		{
+			// Copies are mostly limited by memory bandwidth, a few workers are enough
+			const auto hw_threads = utils::get_thread_count();
+			if (hw_threads > 12)
+			{
+				num_workers = 4;
+			}
+			else if (hw_threads > 8)
+			{
+				num_workers = 2;
+			}
+			else
+			{
+				num_workers = 1;
+			}
+		}
+
+		num_workers = std::min(num_workers, max_offload_threads);
+
+		for (u32 i = 0; i < num_workers; i++)
+		{
+			if (i == 0)
+			{
+				pool.workers.emplace_back(std::make_unique<dma_thread>());
+			}
+			else
+			{
+				pool.workers.emplace_back(std::make_unique<dma_thread>(fmt::format("%s %u", offload_thread::thread_name, i + 1)));
+			}
+		}
+
+		rsx_log.notice("Started %u RSX offload worker(s)", num_workers);
 	}
 
 	// General transport
@@ -103,8 +430,8 @@ namespace rsx
 		}
 		else
 		{
-			g_fxo->get<dma_thread>().m_enqueued_count++;
-			g_fxo->get<dma_thread>().m_work_queue.push(dst, src, length);
+			const auto start = reinterpret_cast<uptr>(dst);
+			g_fxo->get<offload_pool>().dispatch({ start, start + length }, dst, src, length);
 		}
 	}
 
@@ -116,8 +443,9 @@ namespace rsx
 		}
 		else
 		{
-			g_fxo->get<dma_thread>().m_enqueued_count++;
-			g_fxo->get<dma_thread>().m_work_queue.push(dst, src, length);
+			const auto start = reinterpret_cast<uptr>(dst);
+			const auto source = reinterpret_cast<uptr>(src);
+			g_fxo->get<offload_pool>().dispatch({ start, start + length, source, source + length }, dst, src, length);
 		}
 	}
 
@@ -131,8 +459,9 @@ namespace rsx
 		}
 		else
 		{
-			g_fxo->get<dma_thread>().m_enqueued_count++;
-			g_fxo->get<dma_thread>().m_work_queue.push(dst, primitive, count);
+			const auto start = reinterpret_cast<uptr>(dst);
+			const u32 length = get_index_count(primitive, count) * sizeof(u16);
+			g_fxo->get<offload_pool>().dispatch({ start, start + length }, dst, primitive, count);
 		}
 	}
 
@@ -141,21 +470,24 @@ namespace rsx
 	{
 		ensure(g_cfg.video.multithreaded_rsx);
 
-		g_fxo->get<dma_thread>().m_enqueued_count++;
-		g_fxo->get<dma_thread>().m_work_queue.push(request_code, args);
+		// Callbacks are ordered against everything queued before and after them
+		offload_pool::tracked_packet info{};
+		info.barrier = true;
+
+		g_fxo->get<offload_pool>().dispatch(info, request_code, args);
 	}
 
 	// Synchronization
 	bool dma_manager::is_current_thread()
 	{
-		return std::this_thread::get_id() == g_fxo->get<dma_thread>().m_thread_id;
+		return g_tls_offload_worker != nullptr;
 	}
 
 	bool dma_manager::sync() const
 	{
-		auto& _thr = g_fxo->get<dma_thread>();
+		auto& pool = g_fxo->get<offload_pool>();
 
-		if (_thr.m_enqueued_count.load() <= _thr.m_processed_count.load()) [[likely]]
+		if (pool.m_enqueued_count.load() <= pool.m_processed_count.load()) [[likely]]
 		{
 			// Nothing to do
 			return true;
@@ -169,7 +501,7 @@ namespace rsx
 				return false;
 			}
 
-			while (_thr.m_enqueued_count.load() > _thr.m_processed_count.load())
+			while (pool.m_enqueued_count.load() > pool.m_processed_count.load())
 			{
 				rsxthr->on_semaphore_acquire_wait();
 				utils::pause();
@@ -177,22 +509,94 @@ namespace rsx
 		}
 		else
 		{
-			while (_thr.m_enqueued_count.load() > _thr.m_processed_count.load())
+			while (pool.m_enqueued_count.load() > pool.m_processed_count.load())
 				utils::pause();
 		}
 
 		return true;
 	}
 
+	bool dma_manager::sync(const void* address, usz length) const
+	{
+		auto rsxthr = get_current_renderer();
+
+		if (!rsxthr->is_current_thread())
+		{
+			// In-flight packets are only tracked on the RSX thread
+			return sync();
+		}
+
+		auto& pool = g_fxo->get<offload_pool>();
+
+		if (pool.m_enqueued_count.load() <= pool.m_processed_count.load()) [[likely]]
+		{
+			return true;
+		}
+
+		pool.retire_completed();
+
+		offload_pool::tracked_packet range{};
+		range.write_start = reinterpret_cast<uptr>(address);
+		range.write_end = range.write_start + length;
+
+		for (const auto& queue : pool.m_in_flight)
+		{
+			// Newest first, the older packets of a worker are retired before the one waited on
+			for (auto it = queue.rbegin(); it != queue.rend(); ++it)
+			{
+				if (it->barrier || !it->conflicts_with(range))
+				{
+					continue;
+				}
+
+				while (!pool.is_retired(*it))
+				{
+					if (m_mem_fault_flag)
+					{
+						// Abort if a worker is in recovery mode
+						return false;
+					}
+
+					rsxthr->on_semaphore_acquire_wait();
+					utils::pause();
+				}
+
+				break;
+			}
+		}
+
+		return true;
+	}
+
 	void dma_manager::join()
 	{
-		g_fxo->get<dma_thread>() = thread_state::aborting;
-		sync();
+		auto& pool = g_fxo->get<offload_pool>();
+
+		for (auto& worker : pool.workers)
+		{
+			*worker = thread_state::aborting;
+		}
+
+		for (auto& worker : pool.workers)
+		{
+			(*worker)();
+		}
+
+		// Packets left behind by the workers are dropped, and so is anything enqueued from now on
+		for (auto& queue : pool.m_in_flight)
+		{
+			queue.clear();
+		}
+
+		pool.m_processed_count = -1;
 	}
 
 	void dma_manager::set_mem_fault_flag()
 	{
 		ensure(is_current_thread()); // "Access denied"
+
+		// Workers recover from faults one at a time
+		m_mem_fault_lock.lock();
 		m_mem_fault_flag.release(true);
 	}
 
@@ -200,12 +604,13 @@ namespace rsx
 	{
 		ensure(is_current_thread()); // "Access denied"
 		m_mem_fault_flag.release(false);
+		m_mem_fault_lock.unlock();
 	}
 
 	// Fault recovery
 	utils::address_range dma_manager::get_fault_range(bool writing)
 	{
-		const auto m_current_job = ensure(g_fxo->get<dma_thread>().m_current_job);
+		const auto m_current_job = ensure(ensure(g_tls_offload_worker)->m_current_job);
 
 		void *address = nullptr;
 		u32 range = m_current_job->length;
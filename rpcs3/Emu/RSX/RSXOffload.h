@@ -2,6 +2,7 @@
 
 #include "util/types.hpp"
 #include "Utilities/address_range.h"
+#include "Utilities/mutex.h"
 #include "gcm_enums.h"
 
 #include <vector>
@@ -28,6 +29,8 @@ namespace rsx
 			u32 aux_param0{};
 			u32 aux_param1{};
 
+			transport_packet() = default;
+
 			transport_packet(void *_dst, void *_src, u32 len)
 				: type(op::raw_copy), src(_src), dst(_dst), length(len)
 			{}
@@ -46,14 +49,21 @@ namespace rsx
 
 			transport_packet(const transport_packet&) = delete;
 			transport_packet& operator=(const transport_packet&) = delete;
+
+			transport_packet(transport_packet&&) = default;
+			transport_packet& operator=(transport_packet&&) = default;
 		};
 
 		atomic_t<bool> m_mem_fault_flag = false;
+		shared_mutex m_mem_fault_lock;
 
 		// TODO: Improved benchmarks here; value determined by profiling on a Ryzen CPU, rounded to the nearest 512 bytes
 		const u32 max_immediate_transfer_size = 3584;
 
 	public:
+		// Upper limit of the offload worker threads
+		static constexpr u32 max_offload_threads = 8;
+
 		dma_manager() = default;
 
 		// initialization
@@ -72,6 +82,7 @@ namespace rsx
 		// Synchronization
 		static bool is_current_thread();
 		bool sync() const;
+		bool sync(const void* address, usz length) const;
 		void join();
 		void set_mem_fault_flag();
 		void clear_mem_fault_flag();
@@ -80,5 +91,6 @@ namespace rsx
 		static utils::address_range get_fault_range(bool writing);
 
 		struct offload_thread;
+		struct offload_pool;
 	};
 }
@@ -429,7 +429,9 @@ namespace rsx
 	{
 		g_access_violation_handler = [this](u32 address, bool is_writing)
 		{
-			return on_access_violation(address, is_writing);
+			// Release pages write protected by the vertex cache first, the backend may still own the page through the texture cache
+			const bool vertex_fault = is_writing && rsx::page_lock_table.on_write_fault(address);
+			return on_access_violation(address, is_writing) || vertex_fault;
 		};
 
 		m_rtts_dirty = true;
@@ -654,6 +656,7 @@ namespace rsx
 		rsx::overlays::reset_performance_overlay();
 
 		g_fxo->get<rsx::dma_manager>().init();
+		m_method_profiler.init();
 		on_init_thread();
 
 		is_inited = true;
@@ -821,6 +824,10 @@ namespace rsx
 		do_local_task(rsx::FIFO_state::lock_wait);
 
 		g_fxo->get<rsx::dma_manager>().join();
+		m_method_profiler.report();
+
+		// Persist glyphs rasterized since the last periodic atlas save
+		rsx::overlays::fontmgr::flush();
 		state += cpu_flag::exit;
 	}
 
@@ -1050,9 +1057,12 @@ namespace rsx
 
 		if (rsx::method_registers.current_draw_clause.command == rsx::draw_command::indexed)
 		{
+			const auto raw_index_buffer = get_raw_index_array(state.current_draw_clause);
+
 			return draw_indexed_array_command
 			{
-				get_raw_index_array(state.current_draw_clause)
+				raw_index_buffer,
+				element_push_buffer.empty() ? vm::get_addr(raw_index_buffer.data()) : 0u
 			};
 		}
 
@@ -1677,7 +1687,54 @@ namespace rsx
 	void thread::prefetch_fragment_program()
 	{
 		if (!(m_graphics_state & rsx::pipeline_state::fragment_program_ucode_dirty))
-			return;
+		{
+			if (!current_fragment_program.valid)
+			{
+				return;
+			}
+
+			// Inline constants are patched all the time, those only need to be uploaded again.
+			// Rewritten instructions need a new analysis since the program lookups are keyed on the ucode generation.
+			const auto ucode = static_cast<const u8*>(current_fragment_program.get_data());
+			bool instructions_changed = false;
+			bool constants_changed = false;
+
+			for (usz offset = 0; offset < m_fragment_ucode_snapshot.size();)
+			{
+				const auto inst = v128::loadu(m_fragment_ucode_snapshot.data() + offset);
+
+				if (std::memcmp(ucode + offset, &inst, sizeof(inst)))
+				{
+					instructions_changed = true;
+					break;
+				}
+
+				offset += sizeof(inst);
+
+				if (program_hash_util::fragment_program_utils::is_constant(inst._u32[1]) ||
+					program_hash_util::fragment_program_utils::is_constant(inst._u32[2]) ||
+					program_hash_util::fragment_program_utils::is_constant(inst._u32[3]))
+				{
+					if (std::memcmp(ucode + offset, m_fragment_ucode_snapshot.data() + offset, sizeof(inst)))
+					{
+						std::memcpy(m_fragment_ucode_snapshot.data() + offset, ucode + offset, sizeof(inst));
+						constants_changed = true;
+					}
+
+					offset += sizeof(inst);
+				}
+			}
+
+			if (constants_changed || instructions_changed)
+			{
+				m_graphics_state |= rsx::pipeline_state::fragment_constants_dirty;
+			}
+
+			if (!instructions_changed)
+			{
+				return;
+			}
+		}
 
 		m_graphics_state &= ~rsx::pipeline_state::fragment_program_ucode_dirty;
 
@@ -1692,6 +1749,14 @@ namespace rsx
 		current_fragment_program.texture_state.import(current_fp_texture_state, current_fp_metadata.referenced_textures_mask);
 		current_fragment_program.valid = true;
 
+		// Hash the ucode once here instead of on every program lookup until it changes again
+		current_fragment_program.ucode_generation = ++m_program_ucode_generation;
+		current_fragment_program.lookup_hash = 0;
+		current_fragment_program.lookup_hash = program_hash_util::fragment_program_utils::get_fragment_program_lookup_hash(current_fragment_program);
+
+		const auto ucode = static_cast<const u8*>(current_fragment_program.get_data());
+		m_fragment_ucode_snapshot.assign(ucode, ucode + current_fragment_program.ucode_length);
+
 		if (!(m_graphics_state & rsx::pipeline_state::fragment_program_state_dirty))
 		{
 			// Verify current texture state is valid
@@ -1731,6 +1796,10 @@ namespace rsx
 
 		current_vertex_program.texture_state.import(current_vp_texture_state, current_vp_metadata.referenced_textures_mask);
 
+		current_vertex_program.ucode_generation = ++m_program_ucode_generation;
+		current_vertex_program.lookup_hash = 0;
+		current_vertex_program.lookup_hash = program_hash_util::vertex_program_utils::get_vertex_program_lookup_hash(current_vertex_program);
+
 		if (!(m_graphics_state & rsx::pipeline_state::vertex_program_state_dirty))
 		{
 			// Verify current texture state is valid
@@ -2899,6 +2968,7 @@ namespace rsx
 		}
 
 		on_invalidate_memory_range(m_invalidated_memory_range, rsx::invalidation_cause::unmap);
+		rsx::page_lock_table.on_unmap(m_invalidated_memory_range);
 		m_invalidated_memory_range.invalidate();
 	}
 
@@ -11,8 +11,11 @@
 #include "rsx_cache.h"
 #include "RSXFIFO.h"
 #include "RSXOffload.h"
+#include "RSXMethodProfiler.h"
 #include "rsx_utils.h"
 #include "Common/texture_cache_types.h"
+#include "Common/index_array_cache.h"
+#include "Common/texture_cache_stats.h"
 #include "Program/RSXVertexProgram.h"
 #include "Program/RSXFragmentProgram.h"
 
@@ -217,6 +220,7 @@ namespace rsx
 	struct draw_indexed_array_command
 	{
 		std::span<const std::byte> raw_index_buffer;
+		u32 raw_index_address; // 0 if the indices were pushed inline
 	};
 
 	struct draw_inlined_array
@@ -534,6 +538,7 @@ namespace rsx
 	{
 		u32 draw_calls;
 		s64 setup_time;
+		s64 program_lookup_time;
 		s64 vertex_upload_time;
 		s64 textures_upload_time;
 		s64 draw_exec_time;
@@ -607,6 +612,7 @@ namespace rsx
 
 		std::array<push_buffer_vertex_info, 16> vertex_push_buffers;
 		std::vector<u32> element_push_buffer;
+		rsx::index_array_cache m_index_array_cache{ g_cfg.video.index_buffer_cache && !g_cfg.video.disable_vertex_cache };
 
 		s32 m_skip_frame_ctr = 0;
 		bool skip_current_frame = false;
@@ -650,6 +656,7 @@ namespace rsx
 		rsx_iomap_table iomap_table;
 		u32 restore_point = 0;
 		u32 dbg_step_pc = 0;
+		method_profiler m_method_profiler;
 		atomic_t<u32> external_interrupt_lock{ 0 };
 		atomic_t<bool> external_interrupt_ack{ false };
 		atomic_t<bool> is_inited{ false };
@@ -748,6 +755,12 @@ namespace rsx
 		RSXVertexProgram current_vertex_program = {};
 		RSXFragmentProgram current_fragment_program = {};
 
+		// Bumped each time either program ucode is reanalysed, see RSXVertexProgram::ucode_generation
+		u64 m_program_ucode_generation = 0;
+
+		// Copy of the last analysed fragment ucode, the CPU may rewrite it in place without touching the shader registers
+		std::vector<u8> m_fragment_ucode_snapshot;
+
 		vertex_program_texture_state current_vp_texture_state = {};
 		fragment_program_texture_state current_fp_texture_state = {};
 
@@ -964,6 +977,9 @@ namespace rsx
 		// Get RSX approximate load in %
 		u32 get_load();
 
+		// Texture cache activity over the last complete frame
+		virtual texture_cache_frame_statistics get_texture_cache_statistics() const { return {}; }
+
 		// Returns true if the current thread is the active RSX thread
 		bool is_current_thread() const { return std::this_thread::get_id() == m_rsx_thread; }
 	};
@@ -958,6 +958,8 @@ void VKGSRender::end()
 		return;
 	}
 
+	m_frame_stats.program_lookup_time += m_profiler.duration();
+
 	// Allocate descriptor set
 	check_descriptors();
 	m_current_frame->descriptor_set = allocate_descriptor_set();
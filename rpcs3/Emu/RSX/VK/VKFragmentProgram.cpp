@@ -5,8 +5,11 @@
 #include "vkutils/device.h"
 #include "Emu/system_config.h"
 #include "../Program/GLSLCommon.h"
+#include "../Program/decompiled_program_cache.h"
 #include "../GCM.h"
 
+#include "util/serialization.hpp"
+
 std::string VKFragmentDecompilerThread::getFloatTypeName(usz elementCount)
 {
 	return glsl::getFloatTypeNameImpl(elementCount);
@@ -403,24 +406,52 @@ void VKFragmentProgram::Decompile(const RSXFragmentProgram& prog)
 
 	decompiler.device_props.emulate_depth_compare = !pdev->get_formats_support().d24_unorm_s8;
 	decompiler.device_props.has_low_precision_rounding = vk::get_driver_vendor() == vk::driver_vendor::NVIDIA;
-	decompiler.Task();
 
-	shader.create(::glsl::program_domain::glsl_fragment_program, source);
+	// Device and configuration state baked into the generated source
+	const auto binding_table = vk::g_render_device->get_pipeline_binding_table();
+	utils::serial device_state;
+	device_state(decompiler.device_props.has_native_half_support, decompiler.device_props.emulate_depth_compare,
+		decompiler.device_props.has_low_precision_rounding, g_cfg.video.antialiasing_level == msaa_level::none);
+	device_state.raw_serialize(&binding_table, sizeof(binding_table));
 
-	for (const ParamType& PT : decompiler.m_parr.params[PF_PARAM_UNIFORM])
+	if (rsx::decompiled_program_cache_t::entry cached; rsx::decompiled_program_cache.find(prog, device_state.data, cached))
 	{
-		for (const ParamItem& PI : PT.items)
-		{
-			if (PT.type == "sampler1D" ||
-				PT.type == "sampler2D" ||
-				PT.type == "sampler3D" ||
-				PT.type == "samplerCube")
-				continue;
+		utils::serial metadata;
+		metadata.set_reading_state(std::move(cached.metadata));
+
+		std::vector<vk::glsl::program_input> inputs;
+		vk::glsl::serialize_program_inputs(metadata, inputs);
+		metadata(FragmentConstantOffsetCache, output_color_masks);
+
+		SetInputs(inputs);
+		source = std::move(cached.source);
+	}
+	else
+	{
+		decompiler.Task();
 
-			usz offset = atoi(PI.name.c_str() + 2);
-			FragmentConstantOffsetCache.push_back(offset);
+		for (const ParamType& PT : decompiler.m_parr.params[PF_PARAM_UNIFORM])
+		{
+			for (const ParamItem& PI : PT.items)
+			{
+				if (PT.type == "sampler1D" ||
+					PT.type == "sampler2D" ||
+					PT.type == "sampler3D" ||
+					PT.type == "samplerCube")
+					continue;
+
+				usz offset = atoi(PI.name.c_str() + 2);
+				FragmentConstantOffsetCache.push_back(offset);
+			}
 		}
+
+		utils::serial metadata;
+		vk::glsl::serialize_program_inputs(metadata, uniforms);
+		metadata(FragmentConstantOffsetCache, output_color_masks);
+		rsx::decompiled_program_cache.store(prog, device_state.data, { source, std::move(metadata.data) });
 	}
+
+	shader.create(::glsl::program_domain::glsl_fragment_program, source);
 }
 
 void VKFragmentProgram::Compile()
@@ -17,6 +17,7 @@
 #include "Emu/RSX/rsx_methods.h"
 #include "Emu/Memory/vm_locking.h"
 
+#include "../Common/texture_upload_pool.h"
 #include "../Program/program_state_cache2.hpp"
 
 #include "util/asm.hpp"
@@ -498,6 +499,8 @@ VKGSRender::VKGSRender(utils::serial* ar) noexcept : GSRender(ar)
 
 	if (g_cfg.video.disable_vertex_cache || g_cfg.video.multithreaded_rsx)
 		m_vertex_cache = std::make_unique<vk::null_vertex_cache>();
+	else if (g_cfg.video.strict_vertex_cache)
+		m_vertex_cache = std::make_unique<vk::strict_vertex_cache>(VK_ATTRIB_RING_BUFFER_SIZE_M * 0x100000);
 	else
 		m_vertex_cache = std::make_unique<vk::weak_vertex_cache>();
 
@@ -550,6 +553,9 @@ VKGSRender::VKGSRender(utils::serial* ar) noexcept : GSRender(ar)
 	// Async compute and related operations
 	if (g_cfg.video.vk.asynchronous_texture_streaming)
 	{
+		// Move the CPU side of texture uploads off the RSX thread as well
+		rsx::initialize_texture_upload_workers(0);
+
 		// Optimistic, enable async compute and passthrough DMA
 		backend_config.supports_passthrough_dma = m_device->get_external_memory_host_support();
 		backend_config.supports_asynchronous_compute = true;
@@ -611,6 +617,8 @@ VKGSRender::~VKGSRender()
 		g_fxo->get<vk::async_scheduler_thread>().kill();
 	}
 
+	rsx::destroy_texture_upload_workers();
+
 	//Wait for device to finish up with resources
 	vkDeviceWaitIdle(*m_device);
 
@@ -732,13 +740,13 @@ bool VKGSRender::on_access_violation(u32 address, bool is_writing)
 	{
 		if (g_fxo->get<rsx::dma_manager>().is_current_thread())
 		{
-			// The offloader thread cannot handle flush requests
+			// The offloader thread cannot handle flush requests. Other offload workers wait here for their turn
+			g_fxo->get<rsx::dma_manager>().set_mem_fault_flag();
 			ensure(!(m_queue_status & flush_queue_state::deadlock));
 
 			m_offloader_fault_range = g_fxo->get<rsx::dma_manager>().get_fault_range(is_writing);
 			m_offloader_fault_cause = (is_writing) ? rsx::invalidation_cause::write : rsx::invalidation_cause::read;
 
-			g_fxo->get<rsx::dma_manager>().set_mem_fault_flag();
 			m_queue_status |= flush_queue_state::deadlock;
 
 			// Wait for deadlock to clear
@@ -26,6 +26,7 @@ namespace vk
 {
 	using vertex_cache = rsx::vertex_cache::default_vertex_cache<rsx::vertex_cache::uploaded_range<VkFormat>, VkFormat>;
 	using weak_vertex_cache = rsx::vertex_cache::weak_vertex_cache<VkFormat>;
+	using strict_vertex_cache = rsx::vertex_cache::strict_vertex_cache<VkFormat>;
 	using null_vertex_cache = vertex_cache;
 
 	using shader_cache = rsx::shaders_cache<vk::pipeline_props, vk::program_cache>;
@@ -567,6 +568,8 @@ public:
 	void begin_conditional_rendering(const std::vector<rsx::reports::occlusion_query_info*>& sources) override;
 	void end_conditional_rendering() override;
 
+	rsx::texture_cache_frame_statistics get_texture_cache_statistics() const override { return m_texture_cache.get_last_frame_statistics(); }
+
 protected:
 	void clear_surface(u32 mask) override;
 	void begin() override;
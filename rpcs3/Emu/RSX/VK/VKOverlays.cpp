@@ -577,6 +577,7 @@ namespace vk
 
 		resources.clear();
 		font_cache.clear();
+		font_revision_cache.clear();
 		view_cache.clear();
 
 		overlay_pass::destroy();
@@ -611,7 +612,8 @@ namespace vk
 			if (const auto raw = found->second->image();
 				image_size.width == raw->width() &&
 				image_size.height == raw->height() &&
-				image_size.depth == raw->layers())
+				image_size.depth == raw->layers() &&
+				font_revision_cache[key] == font->get_glyph_data_revision())
 			{
 				return found->second.get();
 			}
@@ -626,6 +628,7 @@ namespace vk
 		// Create font resource
 		std::vector<u8> bytes;
 		font->get_glyph_data(bytes);
+		font_revision_cache[key] = font->get_glyph_data_revision();
 
 		return upload_simple_texture(cmd.get_command_pool().get_owner(), cmd, upload_heap, key, image_size.width, image_size.height, image_size.depth,
 				true, false, bytes.data(), -1);
@@ -141,6 +141,7 @@ namespace vk
 
 		std::vector<std::unique_ptr<vk::image>> resources;
 		std::unordered_map<u64, std::unique_ptr<vk::image>> font_cache;
+		std::unordered_map<u64, u64> font_revision_cache;
 		std::unordered_map<u64, std::unique_ptr<vk::image_view>> view_cache;
 		std::unordered_map<u64, std::pair<u32, std::unique_ptr<vk::image>>> temp_image_cache;
 		std::unordered_map<u64, std::unique_ptr<vk::image_view>> temp_view_cache;
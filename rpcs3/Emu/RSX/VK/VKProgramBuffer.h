@@ -95,10 +95,14 @@ namespace vk
 			get_graphics_pipeline(vp, fp, props, false, false, std::forward<Args>(args)...);
 		}
 
-		void preload_programs(RSXVertexProgram& vp, RSXFragmentProgram& fp)
+		void preload_program(RSXVertexProgram& vp)
 		{
 			vp.skip_vertex_input_check = true;
 			search_vertex_program(vp);
+		}
+
+		void preload_program(RSXFragmentProgram& fp)
+		{
 			search_fragment_program(fp);
 		}
 
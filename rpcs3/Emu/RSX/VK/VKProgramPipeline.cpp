@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include "VKProgramPipeline.h"
 #include "vkutils/device.h"
+#include "util/serialization.hpp"
 #include <string>
 
 namespace vk
@@ -283,5 +284,22 @@ namespace vk
 			vkUpdateDescriptorSets(m_device, 1, &descriptor_writer, 0, nullptr);
 			attribute_location_mask |= (1ull << binding_point);
 		}
+
+		void serialize_program_inputs(utils::serial& ar, std::vector<program_input>& inputs)
+		{
+			u32 count = ::size32(inputs);
+			ar(count);
+
+			if (!ar.is_writing())
+			{
+				inputs.clear();
+				inputs.resize(count);
+			}
+
+			for (auto& input : inputs)
+			{
+				ar(input.domain, input.type, input.location, input.name);
+			}
+		}
 	}
 }
@@ -7,6 +7,11 @@
 #include <string>
 #include <vector>
 
+namespace utils
+{
+	struct serial;
+}
+
 namespace vk
 {
 	namespace glsl
@@ -48,6 +53,9 @@ namespace vk
 			std::string name;
 		};
 
+		// (De)serializes the input layout produced by the decompilers. Bound resources are not saved
+		void serialize_program_inputs(utils::serial& ar, std::vector<program_input>& inputs);
+
 		class shader
 		{
 			::glsl::program_domain type = ::glsl::program_domain::glsl_vertex_program;
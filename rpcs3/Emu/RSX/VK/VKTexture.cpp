@@ -12,6 +12,7 @@
 
 #include "../GCM.h"
 #include "../rsx_utils.h"
+#include "../Common/texture_upload_pool.h"
 
 #include "util/asm.hpp"
 
@@ -875,6 +876,9 @@ namespace vk
 		return { row_pitch, upload_pitch_in_texel };
 	}
 
+	// Subresources smaller than this are decoded inline on the RSX thread
+	static constexpr u32 min_async_upload_size = 64 * 1024;
+
 	void upload_image(const vk::command_buffer& cmd, vk::image* dst_image,
 		const std::vector<rsx::subresource_layout>& subresource_layout, int format, bool is_swizzled, u16 /*mipmap_count*/,
 		VkImageAspectFlags flags, vk::data_heap &upload_heap, u32 heap_align, rsx::flags32_t image_setup_flags)
@@ -896,17 +900,54 @@ namespace vk
 		std::vector<std::pair<VkBuffer, u32>> upload_commands;
 		copy_regions.reserve(subresource_layout.size());
 
-		for (const rsx::subresource_layout &layout : subresource_layout)
+		struct subresource_upload_info
+		{
+			u32 row_pitch;
+			u32 upload_pitch_in_texel;
+			u32 image_linear_size;
+			usz offset_in_upload_buffer;
+			rsx::texture_memory_info result;
+		};
+
+		std::vector<subresource_upload_info> uploads(subresource_layout.size());
+
+		// Calculate estimated memory utilization for all subresources
+		usz staging_size = 0;
+
+		for (usz i = 0; i < subresource_layout.size(); ++i)
 		{
+			const rsx::subresource_layout& layout = subresource_layout[i];
+			auto& upload = uploads[i];
+
 			const auto [row_pitch, upload_pitch_in_texel] = calculate_upload_pitch(format, heap_align, dst_image, layout);
-			caps.alignment = row_pitch;
+			upload.row_pitch = row_pitch;
+			upload.upload_pitch_in_texel = upload_pitch_in_texel;
+			upload.image_linear_size = row_pitch * layout.height_in_block * layout.depth;
+
+			// Extra padding bytes in case of realignment
+			upload.offset_in_upload_buffer = staging_size;
+			staging_size = utils::align<usz>(staging_size + upload.image_linear_size + 8, 512);
+		}
 
-			// Calculate estimated memory utilization for this subresource
-			image_linear_size = row_pitch * layout.height_in_block * layout.depth;
+		// Allocate the staging memory at once, the heap may be replaced by a grow and the workers must not see that
+		const usz staging_offset = upload_heap.alloc<512>(staging_size);
+		vk::buffer* staging_buffer = upload_heap.heap.get();
+		auto staging_ptr = static_cast<std::byte*>(upload_heap.map(staging_offset, staging_size));
 
-			// Map with extra padding bytes in case of realignment
-			offset_in_upload_buffer = upload_heap.alloc<512>(image_linear_size + 8);
-			void* mapped_buffer = upload_heap.map(offset_in_upload_buffer, image_linear_size + 8);
+		// CPU side of the upload. Decoding is spread over the upload workers when they are running,
+		// the staging memory is persistently mapped so only the command recording below has to wait for it.
+		rsx::texture_upload_batch upload_batch;
+
+		for (usz i = 0; i < subresource_layout.size(); ++i)
+		{
+			const rsx::subresource_layout& layout = subresource_layout[i];
+			auto& upload = uploads[i];
+
+			caps.alignment = upload.row_pitch;
+			image_linear_size = upload.image_linear_size;
+
+			void* mapped_buffer = staging_ptr + upload.offset_in_upload_buffer;
+			upload.offset_in_upload_buffer += staging_offset;
 
 			// Only do GPU-side conversion if occupancy is good
 			if (check_caps)
@@ -919,12 +960,30 @@ namespace vk
 			}
 
 			std::span<std::byte> mapped{ static_cast<std::byte*>(mapped_buffer), image_linear_size };
-			opt = upload_texture_subresource(mapped, layout, format, is_swizzled, caps);
-			upload_heap.unmap();
+			auto decode = [&upload, &layout, mapped, format, is_swizzled, caps]() mutable
+			{
+				upload.result = upload_texture_subresource(mapped, layout, format, is_swizzled, caps);
+			};
+
+			if (image_linear_size < min_async_upload_size)
+			{
+				// Not worth the round trip
+				decode();
+			}
+			else
+			{
+				upload_batch.submit(std::move(decode));
+			}
+		}
+
+		// Fill in the parts of the copy regions and the command stream that do not depend on the decoded data while the workers run
+		for (usz i = 0; i < subresource_layout.size(); ++i)
+		{
+			const rsx::subresource_layout& layout = subresource_layout[i];
 
 			copy_regions.push_back({});
 			auto& copy_info = copy_regions.back();
-			copy_info.bufferOffset = offset_in_upload_buffer;
+			copy_info.bufferOffset = uploads[i].offset_in_upload_buffer;
 			copy_info.imageExtent.height = layout.height_in_texel;
 			copy_info.imageExtent.width = layout.width_in_texel;
 			copy_info.imageExtent.depth = layout.depth;
@@ -932,9 +991,27 @@ namespace vk
 			copy_info.imageSubresource.layerCount = 1;
 			copy_info.imageSubresource.baseArrayLayer = layout.layer;
 			copy_info.imageSubresource.mipLevel = layout.level;
-			copy_info.bufferRowLength = upload_pitch_in_texel;
+			copy_info.bufferRowLength = uploads[i].upload_pitch_in_texel;
+		}
 
-			upload_buffer = upload_heap.heap.get();
+		auto& cmd2 = prepare_for_transfer(cmd, dst_image, image_setup_flags);
+
+		// The decode results select the source of every region
+		upload_batch.wait();
+		upload_heap.unmap();
+
+		for (usz i = 0; i < subresource_layout.size(); ++i)
+		{
+			const rsx::subresource_layout& layout = subresource_layout[i];
+			auto& upload = uploads[i];
+			auto& copy_info = copy_regions[i];
+
+			const u32 upload_pitch_in_texel = upload.upload_pitch_in_texel;
+			image_linear_size = upload.image_linear_size;
+			offset_in_upload_buffer = upload.offset_in_upload_buffer;
+			opt = std::move(upload.result);
+
+			upload_buffer = staging_buffer;
 
 			if (opt.require_upload)
 			{
@@ -1022,7 +1099,6 @@ namespace vk
 		}
 
 		ensure(upload_buffer);
-		auto& cmd2 = prepare_for_transfer(cmd, dst_image, image_setup_flags);
 
 		if (opt.require_swap || opt.require_deswizzle || requires_depth_processing)
 		{
@@ -91,8 +91,9 @@ namespace
 
 	struct draw_command_visitor
 	{
-		draw_command_visitor(vk::data_heap& index_buffer_ring_info, rsx::vertex_input_layout& layout)
+		draw_command_visitor(vk::data_heap& index_buffer_ring_info, rsx::index_array_cache& index_cache, rsx::vertex_input_layout& layout)
 			: m_index_buffer_ring_info(index_buffer_ring_info)
+			, m_index_cache(index_cache)
 			, m_vertex_layout(layout)
 		{
 		}
@@ -161,9 +162,9 @@ namespace
 			* Upload index (and expands it if primitive type is not natively supported).
 			*/
 			u32 min_index, max_index;
-			std::tie(min_index, max_index, index_count) = write_index_array_data_to_buffer(
+			std::tie(min_index, max_index, index_count) = m_index_cache.write_index_array_data_to_buffer(
 				dst,
-				command.raw_index_buffer, index_type,
+				command.raw_index_buffer, command.raw_index_address, index_type,
 				rsx::method_registers.current_draw_clause.primitive,
 				rsx::method_registers.restart_index_enabled(),
 				rsx::method_registers.restart_index(),
@@ -219,13 +220,14 @@ namespace
 
 	private:
 		vk::data_heap& m_index_buffer_ring_info;
+		rsx::index_array_cache& m_index_cache;
 		rsx::vertex_input_layout& m_vertex_layout;
 	};
 }
 
 vk::vertex_upload_info VKGSRender::upload_vertex_data()
 {
-	draw_command_visitor visitor(m_index_buffer_ring_info, m_vertex_layout);
+	draw_command_visitor visitor(m_index_buffer_ring_info, m_index_array_cache, m_vertex_layout);
 	auto result = std::visit(visitor, get_draw_command(rsx::method_registers));
 
 	const u32 vertex_count = (result.max_index - result.min_index) + 1;
@@ -242,12 +244,12 @@ vk::vertex_upload_info VKGSRender::upload_vertex_data()
 	auto required = calculate_memory_requirements(m_vertex_layout, vertex_base, vertex_count);
 	u32 persistent_range_base = -1, volatile_range_base = -1;
 	usz persistent_offset = -1, volatile_offset = -1;
+	const auto attrib_heap = m_attrib_ring_info.heap.get();
 
 	if (required.first > 0)
 	{
 		//Check if cacheable
 		//Only data in the 'persistent' block may be cached
-		//TODO: make vertex cache keep local data beyond frame boundaries and hook notify command
 		bool in_cache = false;
 		bool to_store = false;
 		u32  storage_address = -1;
@@ -275,6 +277,7 @@ vk::vertex_upload_info VKGSRender::upload_vertex_data()
 		{
 			persistent_offset = static_cast<u32>(m_attrib_ring_info.alloc<256>(required.first));
 			persistent_range_base = static_cast<u32>(persistent_offset);
+			m_vertex_cache->notify_heap_allocation(persistent_range_base, required.first);
 
 			if (to_store)
 			{
@@ -288,6 +291,14 @@ vk::vertex_upload_info VKGSRender::upload_vertex_data()
 	{
 		volatile_offset = static_cast<u32>(m_attrib_ring_info.alloc<256>(required.second));
 		volatile_range_base = static_cast<u32>(volatile_offset);
+		m_vertex_cache->notify_heap_allocation(volatile_range_base, required.second);
+	}
+
+	if (persistent_offset == umax && persistent_range_base != umax && m_attrib_ring_info.heap.get() != attrib_heap)
+	{
+		// The heap was replaced by the volatile allocation after the cache lookup, the cached data is gone
+		persistent_offset = static_cast<u32>(m_attrib_ring_info.alloc<256>(required.first));
+		persistent_range_base = static_cast<u32>(persistent_offset);
 	}
 
 	//Write all the data once if possible
@@ -334,6 +345,9 @@ vk::vertex_upload_info VKGSRender::upload_vertex_data()
 			m_current_frame->buffer_views_to_clean.push_back(std::move(m_volatile_attribute_storage));
 		}
 
+		// Cached ranges point into the old heap
+		m_vertex_cache->purge();
+
 		vk::clear_status_interrupt(vk::heap_changed);
 	}
 
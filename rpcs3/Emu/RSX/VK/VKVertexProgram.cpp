@@ -5,6 +5,9 @@
 #include "VKHelpers.h"
 #include "vkutils/device.h"
 #include "../Program/GLSLCommon.h"
+#include "../Program/decompiled_program_cache.h"
+
+#include "util/serialization.hpp"
 
 
 std::string VKVertexDecompilerThread::getFloatTypeName(usz elementCount)
@@ -328,8 +331,33 @@ VKVertexProgram::~VKVertexProgram()
 void VKVertexProgram::Decompile(const RSXVertexProgram& prog)
 {
 	std::string source;
-	VKVertexDecompilerThread decompiler(prog, source, parr, *this);
-	decompiler.Task();
+
+	// Device state baked into the generated source
+	const auto binding_table = vk::g_render_device->get_pipeline_binding_table();
+	utils::serial device_state;
+	device_state(vk::emulate_conditional_rendering(), vk::g_render_device->get_shader_types_support().allow_float64);
+	device_state.raw_serialize(&binding_table, sizeof(binding_table));
+
+	if (rsx::decompiled_program_cache_t::entry cached; rsx::decompiled_program_cache.find(prog, device_state.data, cached))
+	{
+		utils::serial metadata;
+		metadata.set_reading_state(std::move(cached.metadata));
+
+		std::vector<vk::glsl::program_input> inputs;
+		vk::glsl::serialize_program_inputs(metadata, inputs);
+
+		SetInputs(inputs);
+		source = std::move(cached.source);
+	}
+	else
+	{
+		VKVertexDecompilerThread decompiler(prog, source, parr, *this);
+		decompiler.Task();
+
+		utils::serial metadata;
+		vk::glsl::serialize_program_inputs(metadata, uniforms);
+		rsx::decompiled_program_cache.store(prog, device_state.data, { source, std::move(metadata.data) });
+	}
 
 	shader.create(::glsl::program_domain::glsl_vertex_program, source);
 }
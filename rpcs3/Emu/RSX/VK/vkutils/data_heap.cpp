@@ -67,11 +67,11 @@ namespace vk
 			return false;
 		}
 
-		// Wait for DMA activity to end
-		g_fxo->get<rsx::dma_manager>().sync();
-
 		if (mapped)
 		{
+			// Wait for DMA writes into the old heap to end
+			g_fxo->get<rsx::dma_manager>().sync(_ptr, heap->size());
+
 			// Force reset mapping
 			unmap(true);
 		}
@@ -6,6 +6,9 @@
 #include "Emu/System.h"
 #include "Emu/cache_utils.hpp"
 #include "Common/texture_cache_checker.h"
+#include "Common/page_lock_table.h"
+#include "Common/pipeline_cache_file.h"
+#include "Program/decompiled_program_cache.h"
 #include "Overlays/Shaders/shader_loading_dialog.h"
 
 #include "rsx_utils.h"
@@ -20,8 +23,6 @@ namespace rsx
 	template <typename pipeline_storage_type, typename backend_storage>
 	class shaders_cache
 	{
-		using unpacked_type = lf_fifo<std::tuple<pipeline_storage_type, RSXVertexProgram, RSXFragmentProgram>, 1000>; // TODO: Determine best size
-
 		struct pipeline_data
 		{
 			u64 vertex_program_hash;
@@ -51,70 +52,304 @@ namespace rsx
 			pipeline_storage_type pipeline_properties;
 		};
 
+		using record_type = pipeline_cache_file::record_type;
+
+		// Everything a vertex program is rebuilt from. Pipelines sharing the same key share the program
+		struct vp_key_type
+		{
+			u64 program_hash;
+			u32 ctrl;
+			u32 texture_dimensions;
+			u64 instruction_mask[8];
+			u32 base_address;
+			u32 entry;
+			u16 jump_table[32];
+
+			bool operator==(const vp_key_type&) const = default;
+		};
+
+		struct fp_key_type
+		{
+			u64 program_hash;
+			u32 ctrl;
+			u32 texture_dimensions;
+			u32 texcoord_control;
+			u16 unnormalized_coords;
+			u16 lighting_flags;
+			u16 shadow_textures;
+			u16 redirected_textures;
+			u32 unused; // Explicit padding, the key is hashed as raw memory
+
+			bool operator==(const fp_key_type&) const = default;
+		};
+
+		template <typename T>
+		struct key_hasher
+		{
+			usz operator()(const T& key) const noexcept
+			{
+				return rpcs3::hash_struct(key);
+			}
+		};
+
+		struct pipeline_entry
+		{
+			pipeline_storage_type properties;
+			u32 vp_index;
+			u32 fp_index;
+		};
+
+		// Unique programs referenced by the cached pipelines
+		struct program_set
+		{
+			std::vector<pipeline_data> vp_sources; // First pipeline record using each vertex program
+			std::vector<pipeline_data> fp_sources; // First pipeline record using each fragment program
+
+			std::vector<RSXVertexProgram> vertex_programs;
+			std::vector<RSXFragmentProgram> fragment_programs;
+
+			std::vector<pipeline_entry> pipelines;
+		};
+
 		std::string version_prefix;
 		std::string root_path;
 		std::string pipeline_class_name;
 		lf_fifo<std::unique_ptr<u8[]>, 100> fragment_program_data;
 
 		backend_storage& m_storage;
+		pipeline_cache_file m_cache_file;
 
 		static std::string get_message(u32 index, u32 processed, u32 entry_count)
 		{
-			return fmt::format("%s pipeline object %u of %u", index == 0 ? "Loading" : "Compiling", processed, entry_count);
+			if (index == 0)
+			{
+				return fmt::format("Loading program %u of %u", processed, entry_count);
+			}
+
+			return fmt::format("Compiling pipeline object %u of %u", processed, entry_count);
+		}
+
+		// Splits the pipeline records into their unique programs, so that each program is unpacked and decompiled only once
+		void collect_programs(const std::vector<u64>& pipeline_keys, program_set& programs)
+		{
+			std::unordered_map<vp_key_type, u32, key_hasher<vp_key_type>> vp_index;
+			std::unordered_map<fp_key_type, u32, key_hasher<fp_key_type>> fp_index;
+
+			programs.pipelines.reserve(pipeline_keys.size());
+
+			for (const u64 key : pipeline_keys)
+			{
+				const auto record = m_cache_file.find(record_type::pipeline, key);
+				if (record.size() != sizeof(pipeline_data))
+				{
+					// Unexpected error, but avoid crash
+					continue;
+				}
+
+				pipeline_data pdata{};
+				std::memcpy(&pdata, record.data(), sizeof(pipeline_data));
+
+				vp_key_type vp_key{};
+				vp_key.program_hash = pdata.vertex_program_hash;
+				vp_key.ctrl = pdata.vp_ctrl;
+				vp_key.texture_dimensions = pdata.vp_texture_dimensions;
+				vp_key.base_address = pdata.vp_base_address;
+				vp_key.entry = pdata.vp_entry;
+				std::memcpy(vp_key.instruction_mask, pdata.vp_instruction_mask, sizeof(vp_key.instruction_mask));
+				std::memcpy(vp_key.jump_table, pdata.vp_jump_table, sizeof(vp_key.jump_table));
+
+				fp_key_type fp_key{};
+				fp_key.program_hash = pdata.fragment_program_hash;
+				fp_key.ctrl = pdata.fp_ctrl;
+				fp_key.texture_dimensions = pdata.fp_texture_dimensions;
+				fp_key.texcoord_control = pdata.fp_texcoord_control;
+				fp_key.unnormalized_coords = pdata.fp_unnormalized_coords;
+				fp_key.lighting_flags = pdata.fp_lighting_flags;
+				fp_key.shadow_textures = pdata.fp_shadow_textures;
+				fp_key.redirected_textures = pdata.fp_redirected_textures;
+
+				const auto [vp_it, new_vp] = vp_index.try_emplace(vp_key, ::size32(programs.vp_sources));
+				if (new_vp)
+				{
+					programs.vp_sources.push_back(pdata);
+				}
+
+				const auto [fp_it, new_fp] = fp_index.try_emplace(fp_key, ::size32(programs.fp_sources));
+				if (new_fp)
+				{
+					programs.fp_sources.push_back(pdata);
+				}
+
+				programs.pipelines.push_back({ pdata.pipeline_properties, vp_it->second, fp_it->second });
+			}
+
+			programs.vertex_programs.resize(programs.vp_sources.size());
+			programs.fragment_programs.resize(programs.fp_sources.size());
 		}
 
-		void load_shaders(uint nb_workers, unpacked_type& unpacked, std::string& directory_path, std::vector<fs::dir_entry>& entries, u32 entry_count,
-		    shader_loading_dialog* dlg)
+		void load_programs(uint nb_workers, program_set& programs, shader_loading_dialog* dlg)
 		{
+			const u32 vp_count = ::size32(programs.vp_sources);
+			const u32 entry_count = vp_count + ::size32(programs.fp_sources);
 			atomic_t<u32> processed(0);
 
-			std::function<void(u32)> shader_load_worker = [&](u32 stop_at)
+			std::function<void(u32)> program_load_worker = [&](u32 stop_at)
 			{
 				u32 pos;
-				// Processed is incremented before work starts in order to avoid two workers working on the same shader
+				// Processed is incremented before work starts in order to avoid two workers working on the same program
 				while (((pos = processed++) < stop_at) && !Emu.IsStopped())
 				{
-					fs::dir_entry tmp = entries[pos];
-
-					const auto filename = directory_path + "/" + tmp.name;
-					fs::file f(filename);
-
-					if (!f)
+					if (pos < vp_count)
 					{
-						// Unexpected error, but avoid crash
-						continue;
-					}
+						auto& vp = programs.vertex_programs[pos];
+						vp = unpack_vp(programs.vp_sources[pos]);
 
-					if (f.size() != sizeof(pipeline_data))
+						if (!vp.data.empty())
+						{
+							m_storage.preload_program(vp);
+						}
+					}
+					else
 					{
-						rsx_log.error("Removing cached pipeline object %s since it's not binary compatible with the current shader cache", tmp.name.c_str());
-						fs::remove_file(filename);
-						continue;
+						auto& fp = programs.fragment_programs[pos - vp_count];
+						fp = unpack_fp(programs.fp_sources[pos - vp_count]);
+
+						if (fp.ucode_length)
+						{
+							m_storage.preload_program(fp);
+						}
 					}
+				}
+				// Do not account for an extra program that was never processed
+				processed--;
+			};
 
-					pipeline_data pdata{};
-					f.read(&pdata, f.size());
+			await_workers(nb_workers, 0, program_load_worker, processed, entry_count, dlg);
+		}
 
-					auto entry = unpack(pdata);
+		static u64 get_pipeline_key(const pipeline_data& data)
+		{
+			u64 state_hash = 0;
+			state_hash ^= rpcs3::hash_base<u32>(data.vp_ctrl);
+			state_hash ^= rpcs3::hash_base<u32>(data.fp_ctrl);
+			state_hash ^= rpcs3::hash_base<u32>(data.vp_texture_dimensions);
+			state_hash ^= rpcs3::hash_base<u32>(data.fp_texture_dimensions);
+			state_hash ^= rpcs3::hash_base<u32>(data.fp_texcoord_control);
+			state_hash ^= rpcs3::hash_base<u16>(data.fp_unnormalized_coords);
+			state_hash ^= rpcs3::hash_base<u16>(data.fp_height);
+			state_hash ^= rpcs3::hash_base<u16>(data.fp_pixel_layout);
+			state_hash ^= rpcs3::hash_base<u16>(data.fp_lighting_flags);
+			state_hash ^= rpcs3::hash_base<u16>(data.fp_shadow_textures);
+			state_hash ^= rpcs3::hash_base<u16>(data.fp_redirected_textures);
 
-					if (std::get<1>(entry).data.empty() || !std::get<2>(entry).ucode_length)
-					{
-						continue;
-					}
+			u64 key = rpcs3::fnv_seed;
+			key = rpcs3::hash64(key, data.vertex_program_hash);
+			key = rpcs3::hash64(key, data.fragment_program_hash);
+			key = rpcs3::hash64(key, data.pipeline_storage_hash);
+			key = rpcs3::hash64(key, state_hash);
+			return key;
+		}
+
+		void open_cache_file()
+		{
+			const std::string class_path = root_path + "/pipelines/" + pipeline_class_name;
+			const std::string file_path = class_path + "/" + version_prefix + ".dat";
+
+			fs::create_path(class_path);
+
+			if (!m_cache_file.open(file_path, sizeof(pipeline_data)))
+			{
+				return;
+			}
+
+			if (convert_legacy_cache())
+			{
+				// Read back the converted entries
+				m_cache_file.open(file_path, sizeof(pipeline_data));
+			}
+		}
 
-					m_storage.preload_programs(std::get<1>(entry), std::get<2>(entry));
+		void open_decompiled_program_cache()
+		{
+			// Shares the version of the pipeline cache, bumping it means the generated source changed
+			const std::string class_path = root_path + "/decompiled/" + pipeline_class_name;
+			fs::create_path(class_path);
 
-					unpacked[unpacked.push_begin()] = std::move(entry);
+			decompiled_program_cache.open(class_path + "/" + version_prefix + ".dat");
+		}
+
+		// Moves the pipelines stored as individual files by older builds into the packed file
+		bool convert_legacy_cache()
+		{
+			const std::string legacy_path = root_path + "/pipelines/" + pipeline_class_name + "/" + version_prefix;
+
+			fs::dir root(legacy_path);
+			if (!root)
+			{
+				return false;
+			}
+
+			auto convert_raw_program = [this](record_type type, u64 hash, const char* extension)
+			{
+				if (m_cache_file.contains(type, hash))
+				{
+					return true;
 				}
-				// Do not account for an extra shader that was never processed
-				processed--;
+
+				fs::file f(fmt::format("%s/raw/%llX.%s", root_path, hash, extension));
+				if (!f)
+				{
+					return false;
+				}
+
+				const auto ucode = f.to_vector<u8>();
+				return !ucode.empty() && m_cache_file.append(type, hash, ucode.data(), ::size32(ucode));
 			};
 
-			await_workers(nb_workers, 0, shader_load_worker, processed, entry_count, dlg);
+			u32 converted = 0;
+
+			for (auto&& entry : root)
+			{
+				if (entry.is_directory || entry.size != sizeof(pipeline_data))
+				{
+					continue;
+				}
+
+				fs::file f(legacy_path + "/" + entry.name);
+
+				pipeline_data pdata{};
+				if (!f || !f.read(pdata))
+				{
+					continue;
+				}
+
+				if (!convert_raw_program(record_type::vertex_program, pdata.vertex_program_hash, "vp") ||
+					!convert_raw_program(record_type::fragment_program, pdata.fragment_program_hash, "fp"))
+				{
+					continue;
+				}
+
+				if (m_cache_file.append(record_type::pipeline, get_pipeline_key(pdata), &pdata, sizeof(pipeline_data)))
+				{
+					converted++;
+				}
+			}
+
+			root.close();
+
+			rsx_log.success("shaders_cache: Converted %u pipeline objects from %s", converted, legacy_path);
+
+			// The raw programs are left in place, they may still be referenced by the cache of another backend
+			if (!fs::remove_all(legacy_path))
+			{
+				rsx_log.error("shaders_cache: Failed to remove legacy cache directory %s (%s)", legacy_path, fs::g_tls_error);
+			}
+
+			return true;
 		}
 
 		template <typename... Args>
-		void compile_shaders(uint nb_workers, unpacked_type& unpacked, u32 entry_count, shader_loading_dialog* dlg, Args&&... args)
+		void compile_shaders(uint nb_workers, program_set& programs, u32 entry_count, shader_loading_dialog* dlg, Args&&... args)
 		{
 			atomic_t<u32> processed(0);
 
@@ -124,8 +359,12 @@ namespace rsx
 				// Processed is incremented before work starts in order to avoid two workers working on the same shader
 				while (((pos = processed++) < stop_at) && !Emu.IsStopped())
 				{
-					auto& entry = unpacked[pos];
-					m_storage.add_pipeline_entry(std::get<1>(entry), std::get<2>(entry), std::get<0>(entry), std::forward<Args>(args)...);
+					auto& entry = programs.pipelines[pos];
+
+					// The programs are shared between workers, the backend gets its own copy to work with
+					auto vp = programs.vertex_programs[entry.vp_index];
+					auto fp = programs.fragment_programs[entry.fp_index];
+					m_storage.add_pipeline_entry(vp, fp, entry.properties, std::forward<Args>(args)...);
 				}
 				// Do not account for an extra shader that was never processed
 				processed--;
@@ -202,10 +441,17 @@ namespace rsx
 				if (std::string cache_path = rpcs3::cache::get_ppu_cache(); !cache_path.empty())
 				{
 					root_path = std::move(cache_path) + "shaders_cache/";
+					open_cache_file();
+					open_decompiled_program_cache();
 				}
 			}
 		}
 
+		~shaders_cache()
+		{
+			decompiled_program_cache.close();
+		}
+
 		template <typename... Args>
 		void load(shader_loading_dialog* dlg, Args&& ...args)
 		{
@@ -214,34 +460,15 @@ namespace rsx
 				return;
 			}
 
-			std::string directory_path = root_path + "/pipelines/" + pipeline_class_name + "/" + version_prefix;
+			const auto& pipeline_keys = m_cache_file.get_pipeline_keys();
+			u32 entry_count = ::size32(pipeline_keys);
 
-			fs::dir root = fs::dir(directory_path);
-
-			if (!root)
+			if (!entry_count)
 			{
-				fs::create_path(directory_path);
-				fs::create_path(root_path + "/raw");
+				m_cache_file.release_contents();
 				return;
 			}
 
-			std::vector<fs::dir_entry> entries;
-
-			for (auto&& tmp : root)
-			{
-				if (tmp.is_directory)
-					continue;
-
-				entries.push_back(tmp);
-			}
-
-			u32 entry_count = ::size32(entries);
-
-			if (!entry_count)
-				return;
-
-			root.rewind();
-
 			// Progress dialog
 			std::unique_ptr<shader_loading_dialog> fallback_dlg;
 			if (!dlg)
@@ -250,22 +477,38 @@ namespace rsx
 				dlg = fallback_dlg.get();
 			}
 
+			program_set programs;
+			collect_programs(pipeline_keys, programs);
+
+			const u32 program_count = ::size32(programs.vp_sources) + ::size32(programs.fp_sources);
+
 			dlg->create("Preloading cached shaders from disk.\nPlease wait...", "Shader Compilation");
-			dlg->set_limit(0, entry_count);
+			dlg->set_limit(0, program_count);
 			dlg->set_limit(1, entry_count);
-			dlg->update_msg(0, get_message(0, 0, entry_count));
+			dlg->update_msg(0, get_message(0, 0, program_count));
 			dlg->update_msg(1, get_message(1, 0, entry_count));
 
-			// Preload everything needed to compile the shaders
-			unpacked_type unpacked;
+			// Decompile every unique program once, the pipelines only reference them
 			uint nb_workers = g_cfg.video.renderer == video_renderer::vulkan ? utils::get_thread_count() : 1;
 
-			load_shaders(nb_workers, unpacked, directory_path, entries, entry_count, dlg);
+			load_programs(nb_workers, programs, dlg);
+
+			// Everything needed has been copied out
+			m_cache_file.release_contents();
 
-			// Account for any invalid entries
-			entry_count = unpacked.size();
+			// Drop the pipelines referencing invalid programs
+			std::erase_if(programs.pipelines, [&](const pipeline_entry& entry)
+			{
+				return programs.vertex_programs[entry.vp_index].data.empty() || !programs.fragment_programs[entry.fp_index].ucode_length;
+			});
+
+			rsx_log.notice("shaders_cache: %u pipeline objects use %u unique vertex and %u unique fragment programs",
+				::size32(programs.pipelines), ::size32(programs.vp_sources), ::size32(programs.fp_sources));
+
+			entry_count = ::size32(programs.pipelines);
+			dlg->set_limit(1, entry_count);
 
-			compile_shaders(nb_workers, unpacked, entry_count, dlg, std::forward<Args>(args)...);
+			compile_shaders(nb_workers, programs, entry_count, dlg, std::forward<Args>(args)...);
 
 			dlg->refresh();
 			dlg->close();
@@ -286,45 +529,27 @@ namespace rsx
 
 			pipeline_data data = pack(pipeline, vp, fp);
 
-			std::string fp_name = root_path + "/raw/" + fmt::format("%llX.fp", data.fragment_program_hash);
-			std::string vp_name = root_path + "/raw/" + fmt::format("%llX.vp", data.vertex_program_hash);
-
-			// Writeback to cache either if file does not exist or it is invalid (unexpected size)
-			// Note: fs::write_file is not atomic, if the process is terminated in the middle an empty file is created
-			if (fs::stat_t s{}; !fs::stat(fp_name, s) || s.size != fp.ucode_length)
+			// Programs are shared between pipelines, only the first pipeline using them writes them out
+			if (!m_cache_file.contains(record_type::fragment_program, data.fragment_program_hash))
 			{
-				fs::write_file(fp_name, fs::rewrite, fp.get_data(), fp.ucode_length);
+				m_cache_file.append(record_type::fragment_program, data.fragment_program_hash, fp.get_data(), fp.ucode_length);
 			}
 
-			if (fs::stat_t s{}; !fs::stat(vp_name, s) || s.size != vp.data.size() * sizeof(u32))
+			if (!m_cache_file.contains(record_type::vertex_program, data.vertex_program_hash))
 			{
-				fs::write_file(vp_name, fs::rewrite, vp.data);
+				m_cache_file.append(record_type::vertex_program, data.vertex_program_hash, vp.data.data(), ::size32(vp.data) * sizeof(u32));
 			}
 
-			u64 state_hash = 0;
-			state_hash ^= rpcs3::hash_base<u32>(data.vp_ctrl);
-			state_hash ^= rpcs3::hash_base<u32>(data.fp_ctrl);
-			state_hash ^= rpcs3::hash_base<u32>(data.vp_texture_dimensions);
-			state_hash ^= rpcs3::hash_base<u32>(data.fp_texture_dimensions);
-			state_hash ^= rpcs3::hash_base<u32>(data.fp_texcoord_control);
-			state_hash ^= rpcs3::hash_base<u16>(data.fp_unnormalized_coords);
-			state_hash ^= rpcs3::hash_base<u16>(data.fp_height);
-			state_hash ^= rpcs3::hash_base<u16>(data.fp_pixel_layout);
-			state_hash ^= rpcs3::hash_base<u16>(data.fp_lighting_flags);
-			state_hash ^= rpcs3::hash_base<u16>(data.fp_shadow_textures);
-			state_hash ^= rpcs3::hash_base<u16>(data.fp_redirected_textures);
-
-			const std::string pipeline_file_name = fmt::format("%llX+%llX+%llX+%llX.bin", data.vertex_program_hash, data.fragment_program_hash, data.pipeline_storage_hash, state_hash);
-			const std::string pipeline_path = root_path + "/pipelines/" + pipeline_class_name + "/" + version_prefix + "/" + pipeline_file_name;
-			fs::write_file(pipeline_path, fs::rewrite, &data, sizeof(data));
+			m_cache_file.append(record_type::pipeline, get_pipeline_key(data), &data, sizeof(data));
 		}
 
 		RSXVertexProgram load_vp_raw(u64 program_hash) const
 		{
 			RSXVertexProgram vp = {};
 
-			fs::file f(fmt::format("%s/raw/%llX.vp", root_path, program_hash));
-			if (f) f.read(vp.data, f.size() / sizeof(u32));
+			const auto ucode = m_cache_file.find(record_type::vertex_program, program_hash);
+			vp.data.resize(ucode.size() / sizeof(u32));
+			std::memcpy(vp.data.data(), ucode.data(), vp.data.size() * sizeof(u32));
 
 			vp.skip_vertex_input_check = true;
 
@@ -333,11 +558,11 @@ namespace rsx
 
 		RSXFragmentProgram load_fp_raw(u64 program_hash)
 		{
-			fs::file f(fmt::format("%s/raw/%llX.fp", root_path, program_hash));
+			const auto ucode = m_cache_file.find(record_type::fragment_program, program_hash);
 
 			RSXFragmentProgram fp = {};
 
-			const u32 size = fp.ucode_length = f ? ::size32(f) : 0;
+			const u32 size = fp.ucode_length = ::size32(ucode);
 
 			if (!size)
 			{
@@ -346,19 +571,14 @@ namespace rsx
 
 			auto buf = std::make_unique<u8[]>(size);
 			fp.data = buf.get();
-			f.read(buf.get(), size);
+			std::memcpy(buf.get(), ucode.data(), size);
 			fragment_program_data[fragment_program_data.push_begin()] = std::move(buf);
 			return fp;
 		}
 
-		std::tuple<pipeline_storage_type, RSXVertexProgram, RSXFragmentProgram> unpack(pipeline_data &data)
+		RSXVertexProgram unpack_vp(const pipeline_data& data) const
 		{
-			std::tuple<pipeline_storage_type, RSXVertexProgram, RSXFragmentProgram> result;
-			auto& [pipeline, vp, fp] = result;
-
-			vp = load_vp_raw(data.vertex_program_hash);
-			fp = load_fp_raw(data.fragment_program_hash);
-			pipeline = data.pipeline_properties;
+			RSXVertexProgram vp = load_vp_raw(data.vertex_program_hash);
 
 			vp.output_mask = data.vp_ctrl;
 			vp.texture_state.texture_dimensions = data.vp_texture_dimensions;
@@ -379,6 +599,13 @@ namespace rsx
 				vp.jump_table.emplace(address);
 			}
 
+			return vp;
+		}
+
+		RSXFragmentProgram unpack_fp(const pipeline_data& data)
+		{
+			RSXFragmentProgram fp = load_fp_raw(data.fragment_program_hash);
+
 			fp.ctrl = data.fp_ctrl;
 			fp.texture_state.texture_dimensions = data.fp_texture_dimensions;
 			fp.texture_state.unnormalized_coords = data.fp_unnormalized_coords;
@@ -387,7 +614,7 @@ namespace rsx
 			fp.texcoord_control_mask = data.fp_texcoord_control;
 			fp.two_sided_lighting = !!(data.fp_lighting_flags & 0x1);
 
-			return result;
+			return fp;
 		}
 
 		pipeline_data pack(const pipeline_storage_type &pipeline, const RSXVertexProgram &vp, const RSXFragmentProgram &fp)
@@ -445,12 +672,13 @@ namespace rsx
 			virtual ~default_vertex_cache() = default;
 			virtual storage_type* find_vertex_range(uptr /*local_addr*/, upload_format, u32 /*data_length*/) { return nullptr; }
 			virtual void store_range(uptr /*local_addr*/, upload_format, u32 /*data_length*/, u32 /*offset_in_heap*/) {}
+			virtual void notify_heap_allocation(u32 /*offset_in_heap*/, u32 /*data_length*/) {}
+			virtual void on_frame_end() { purge(); }
 			virtual void purge() {}
 		};
 
 		// A weak vertex cache with no data checks or memory range locks
 		// Of limited use since contents are only guaranteed to be valid once per frame
-		// TODO: Strict vertex cache with range locks
 		template <typename upload_format>
 		struct uploaded_range
 		{
@@ -458,6 +686,7 @@ namespace rsx
 			upload_format buffer_format;
 			u32 offset_in_heap;
 			u32 data_length;
+			u64 heap_position;
 		};
 
 		template <typename upload_format>
@@ -500,5 +729,224 @@ namespace rsx
 				vertex_ranges.clear();
 			}
 		};
+
+		// A strict vertex cache which keeps uploaded data across frame boundaries
+		// Source memory is write protected through the page lock table; a guest write to a locked page drops every range touching it
+		// Uploaded data lives in the attribute ring heap, so entries also expire once the heap has moved far enough to recycle them
+		template <typename upload_format>
+		class strict_vertex_cache : public default_vertex_cache<uploaded_range<upload_format>, upload_format>
+		{
+			using storage_type = uploaded_range<upload_format>;
+
+			// Pages written to this many times are considered dynamic and are no longer cached
+			static constexpr u8 max_page_invalidations = 4;
+
+		private:
+			std::unordered_map<uptr, std::vector<storage_type>> vertex_ranges;
+			std::unordered_map<u32, u32> locked_pages;         // Page address -> number of cached ranges touching it
+			std::unordered_map<u32, u8> page_invalidations;    // Page address -> number of times cached data was invalidated by a write
+
+			const u32 m_heap_size;
+			const bool m_discard_on_heap_wrap;
+			u32 m_heap_put_pos = 0;
+			u64 m_heap_position = 0;
+
+			static utils::address_range get_page_range(uptr local_addr, u32 data_length)
+			{
+				return utils::address_range::start_length(static_cast<u32>(local_addr), data_length).to_page_range();
+			}
+
+			void release_pages(const utils::address_range& range)
+			{
+				for (u32 page = range.start; page < range.end; page += 4096)
+				{
+					auto found = locked_pages.find(page);
+					if (found == locked_pages.end())
+					{
+						// Already released by a write fault
+						continue;
+					}
+
+					if (--found->second == 0)
+					{
+						locked_pages.erase(found);
+						page_lock_table.unlock_range(page_lock_owner::vertex_cache, utils::address_range::start_length(page, 4096));
+					}
+				}
+			}
+
+			bool is_heap_data_valid(const storage_type& v) const
+			{
+				// Only reuse data that has not aged past half the heap. The remaining half is headroom for draws still in flight
+				return (m_heap_position - v.heap_position) <= (m_heap_size / 2);
+			}
+
+			void process_invalidated_ranges()
+			{
+				if (!page_lock_table.has_invalidated_ranges(page_lock_owner::vertex_cache)) [[likely]]
+				{
+					return;
+				}
+
+				for (const auto& invalidated : page_lock_table.take_invalidated_ranges(page_lock_owner::vertex_cache))
+				{
+					for (u32 page = invalidated.start; page < invalidated.end; page += 4096)
+					{
+						// The fault handler already dropped the lock on this page, but it may have been locked again since
+						locked_pages.erase(page);
+						page_lock_table.unlock_range(page_lock_owner::vertex_cache, utils::address_range::start_length(page, 4096));
+
+						if (u8& count = page_invalidations[page]; count < max_page_invalidations)
+						{
+							count++;
+						}
+					}
+
+					for (auto it = vertex_ranges.begin(); it != vertex_ranges.end();)
+					{
+						auto& ranges = it->second;
+
+						for (auto v = ranges.begin(); v != ranges.end();)
+						{
+							const auto range = get_page_range(v->local_address, v->data_length);
+							if (range.overlaps(invalidated))
+							{
+								release_pages(range);
+								v = ranges.erase(v);
+							}
+							else
+							{
+								++v;
+							}
+						}
+
+						if (ranges.empty())
+						{
+							it = vertex_ranges.erase(it);
+						}
+						else
+						{
+							++it;
+						}
+					}
+				}
+			}
+
+			void release_all()
+			{
+				for (const auto& page : locked_pages)
+				{
+					page_lock_table.unlock_range(page_lock_owner::vertex_cache, utils::address_range::start_length(page.first, 4096));
+				}
+
+				vertex_ranges.clear();
+				locked_pages.clear();
+			}
+
+		public:
+
+			strict_vertex_cache(u32 heap_size, bool discard_on_heap_wrap = false)
+				: m_heap_size(heap_size)
+				, m_discard_on_heap_wrap(discard_on_heap_wrap)
+			{}
+
+			~strict_vertex_cache()
+			{
+				purge();
+			}
+
+			storage_type* find_vertex_range(uptr local_addr, upload_format fmt, u32 data_length) override
+			{
+				process_invalidated_ranges();
+
+				const auto found = vertex_ranges.find(local_addr);
+				if (found == vertex_ranges.end())
+				{
+					return nullptr;
+				}
+
+				auto& ranges = found->second;
+				for (auto v = ranges.begin(); v != ranges.end(); ++v)
+				{
+					if (v->buffer_format != fmt || v->data_length != data_length)
+					{
+						continue;
+					}
+
+					if (!is_heap_data_valid(*v))
+					{
+						// Backing heap memory is about to be recycled, upload again
+						release_pages(get_page_range(v->local_address, v->data_length));
+						ranges.erase(v);
+						return nullptr;
+					}
+
+					return &(*v);
+				}
+
+				return nullptr;
+			}
+
+			void store_range(uptr local_addr, upload_format fmt, u32 data_length, u32 offset_in_heap) override
+			{
+				const auto range = get_page_range(local_addr, data_length);
+
+				for (u32 page = range.start; page < range.end; page += 4096)
+				{
+					if (const auto found = page_invalidations.find(page);
+						found != page_invalidations.end() && found->second >= max_page_invalidations)
+					{
+						// Dynamic data, not worth the page faults
+						return;
+					}
+				}
+
+				// Lock before the backend reads the data so that any later write is caught
+				page_lock_table.lock_range(page_lock_owner::vertex_cache, range);
+
+				for (u32 page = range.start; page < range.end; page += 4096)
+				{
+					locked_pages[page]++;
+				}
+
+				storage_type v = {};
+				v.buffer_format = fmt;
+				v.data_length = data_length;
+				v.local_address = local_addr;
+				v.offset_in_heap = offset_in_heap;
+				v.heap_position = m_heap_position;
+
+				vertex_ranges[local_addr].push_back(v);
+			}
+
+			void notify_heap_allocation(u32 offset_in_heap, u32 data_length) override
+			{
+				if (offset_in_heap < m_heap_put_pos)
+				{
+					// Heap wrapped around
+					if (m_discard_on_heap_wrap)
+					{
+						release_all();
+					}
+
+					m_heap_position += (m_heap_size - m_heap_put_pos);
+					m_heap_put_pos = 0;
+				}
+
+				m_heap_position += (offset_in_heap + data_length - m_heap_put_pos);
+				m_heap_put_pos = offset_in_heap + data_length;
+			}
+
+			void on_frame_end() override
+			{
+				// Contents survive across frames
+			}
+
+			void purge() override
+			{
+				release_all();
+				page_invalidations.clear();
+			}
+		};
 	}
 }
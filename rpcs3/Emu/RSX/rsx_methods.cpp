@@ -6,6 +6,7 @@
 #include "Emu/Cell/PPUCallback.h"
 #include "Emu/Cell/lv2/sys_rsx.h"
 #include "Emu/RSX/Common/BufferUtils.h"
+#include "Emu/perf_meter.hpp"
 
 #include <thread>
 
@@ -516,7 +517,17 @@ namespace rsx
 					return;
 				}
 
-				rsxthr->begin();
+				if (rsxthr->m_method_profiler.enabled()) [[unlikely]]
+				{
+					const u64 start = get_tsc();
+					rsxthr->begin();
+					rsxthr->m_method_profiler.record(method_profiler::phase_draw_begin, start, get_tsc());
+				}
+				else
+				{
+					rsxthr->begin();
+				}
+
 				return;
 			}
 
@@ -555,7 +566,17 @@ namespace rsx
 				}
 
 				rsx::method_registers.current_draw_clause.compile();
-				rsxthr->end();
+
+				if (rsxthr->m_method_profiler.enabled()) [[unlikely]]
+				{
+					const u64 start = get_tsc();
+					rsxthr->end();
+					rsxthr->m_method_profiler.record(method_profiler::phase_draw_end, start, get_tsc());
+				}
+				else
+				{
+					rsxthr->end();
+				}
 			}
 			else
 			{
@@ -3,6 +3,7 @@
 #include "rsx_methods.h"
 #include "Emu/RSX/GCM.h"
 #include "Overlays/overlays.h"
+#include "Common/page_lock_table.h"
 
 #ifdef _MSC_VER
 #pragma warning(push, 0)
@@ -24,11 +25,301 @@ extern "C"
 #endif
 
 #include "util/sysinfo.hpp"
+#include "util/asm.hpp"
+#include "Utilities/Thread.h"
+
+#include "immintrin.h"
+
+#if defined(_MSC_VER)
+#define BMI2_FUNC
+#else
+#define BMI2_FUNC __attribute__((__target__("bmi2")))
+#endif // _MSC_VER
 
 namespace rsx
 {
 	atomic_t<u64> g_rsx_shared_tag{ 0 };
 
+	namespace swizzle
+	{
+		const bool s_use_bmi2 = utils::has_bmi2();
+
+		BMI2_FUNC static u32 bmi2_deposit(u32 value, u32 mask)
+		{
+			return _pdep_u32(value, mask);
+		}
+
+		static u32 deposit_bits(u32 value, u32 mask)
+		{
+			if (s_use_bmi2)
+			{
+				return bmi2_deposit(value, mask);
+			}
+
+			u32 result = 0;
+			for (u32 bit = 1; mask; bit <<= 1)
+			{
+				const u32 lowest = mask & (0 - mask);
+				if (value & bit)
+				{
+					result |= lowest;
+				}
+
+				mask &= mask - 1;
+			}
+
+			return result;
+		}
+
+		template <u32 Size>
+		struct texel_t
+		{
+			u8 data[Size];
+		};
+
+		// Images smaller than this are not worth waking up more threads for
+		static constexpr usz min_parallel_image_size = 4 * 0x100000;
+		static constexpr u32 rows_per_band = 64;
+
+		struct layout_t
+		{
+			u32 x_mask;
+			u32 y_mask;
+			u32 log2_limit; // log2 of the smaller dimension, bits above 2x this are x-carry only
+
+			// Morton offsets of the first texel of row y, split into the x (carry) and y parts
+			u32 row_x_base(u32 y) const
+			{
+				return deposit_bits((y >> log2_limit) << log2_limit, x_mask);
+			}
+
+			u32 row_y_offset(u32 y) const
+			{
+				return deposit_bits(y & ((1u << log2_limit) - 1), y_mask);
+			}
+		};
+
+		template <typename T, bool input_is_swizzled>
+		static void convert_rows(const T* src, T* dst, const layout_t& layout, u32 width, u32 y_begin, u32 y_end, u32 adv)
+		{
+			for (u32 y = y_begin; y < y_end; ++y)
+			{
+				u32 offs_x = layout.row_x_base(y);
+				const u32 offs_y = layout.row_y_offset(y);
+
+				if constexpr (!input_is_swizzled)
+				{
+					const T* row = src + y * adv;
+					T* out = dst + offs_y;
+
+					for (u32 x = 0; x < width; ++x)
+					{
+						out[offs_x] = row[x];
+						offs_x = (offs_x - layout.x_mask) & layout.x_mask;
+					}
+				}
+				else
+				{
+					const T* in = src + offs_y;
+					T* row = dst + y * adv;
+
+					for (u32 x = 0; x < width; ++x)
+					{
+						row[x] = in[offs_x];
+						offs_x = (offs_x - layout.x_mask) & layout.x_mask;
+					}
+				}
+			}
+		}
+
+		// Converts whole 4x4 tiles. With at least 2 bits of interleave, a tile occupies 16 contiguous texels in the swizzled image
+		// and every linear row of the tile maps to two pairs of adjacent swizzled texels, so we can move 2 texels at a time.
+		template <typename T, bool input_is_swizzled>
+		static void convert_tiles(const T* src, T* dst, const layout_t& layout, u32 width, u32 y_begin, u32 y_end, u32 adv)
+		{
+			using pair_t = texel_t<sizeof(T) * 2>;
+
+			// Offsets of the 4 pairs making up the tile, in linear row order
+			static constexpr u32 pair_offsets[4][2] = { { 0, 4 }, { 2, 6 }, { 8, 12 }, { 10, 14 } };
+
+			// Advancing x by 4 in morton space moves bit 2 of x, which lands on bit 4 of the offset
+			const u32 x_carry = ~layout.x_mask;
+
+			for (u32 y = y_begin; y < y_end; y += 4)
+			{
+				u32 offs_x = layout.row_x_base(y);
+				const u32 offs_y = layout.row_y_offset(y);
+
+				for (u32 x = 0; x < width; x += 4)
+				{
+					const u32 tile = offs_x + offs_y;
+
+					for (u32 r = 0; r < 4; ++r)
+					{
+						if constexpr (!input_is_swizzled)
+						{
+							const T* in = src + (y + r) * adv + x;
+							T* out = dst + tile;
+
+							std::memcpy(out + pair_offsets[r][0], in, sizeof(pair_t));
+							std::memcpy(out + pair_offsets[r][1], in + 2, sizeof(pair_t));
+						}
+						else
+						{
+							const T* in = src + tile;
+							T* out = dst + (y + r) * adv + x;
+
+							std::memcpy(out, in + pair_offsets[r][0], sizeof(pair_t));
+							std::memcpy(out + 2, in + pair_offsets[r][1], sizeof(pair_t));
+						}
+					}
+
+					offs_x = ((offs_x | x_carry) + 16) & layout.x_mask;
+				}
+			}
+		}
+
+		template <typename T, bool input_is_swizzled>
+		static void convert_linear_swizzle(const void* input_pixels, void* output_pixels, u16 width, u16 height, u32 pitch)
+		{
+			const u32 log2width = ceil_log2(width);
+			const u32 log2height = ceil_log2(height);
+
+			// We have to limit the masks to the lower of the two dimensions to allow for non-square textures
+			const u32 log2_limit = std::min(log2width, log2height);
+			// Double the limit to account for bits in both x and y
+			const u32 limit_mask = 1u << (log2_limit << 1);
+
+			layout_t layout;
+			layout.x_mask = 0x55555555 | ~(limit_mask - 1); // Bits above limit are 1's for x-carry
+			layout.y_mask = 0xAAAAAAAA & (limit_mask - 1);  // Bits above limit are 0'd, y-carry is folded into the x part
+			layout.log2_limit = log2_limit;
+
+			const auto src = static_cast<const T*>(input_pixels);
+			const auto dst = static_cast<T*>(output_pixels);
+			const u32 adv = pitch / sizeof(T);
+
+			const bool use_tiles = log2_limit >= 2 && (width % 4) == 0 && (height % 4) == 0;
+
+			auto convert_band = [&](u32 y_begin, u32 y_end)
+			{
+				if (use_tiles)
+				{
+					convert_tiles<T, input_is_swizzled>(src, dst, layout, width, y_begin, y_end, adv);
+				}
+				else
+				{
+					convert_rows<T, input_is_swizzled>(src, dst, layout, width, y_begin, y_end, adv);
+				}
+			};
+
+			const usz image_size = usz{width} * height * sizeof(T);
+			const u32 band_count = utils::aligned_div(u32{height}, rows_per_band);
+			const u32 thread_count = std::min({ utils::get_thread_count() / 2, 4u, band_count });
+
+			if (image_size < min_parallel_image_size || thread_count < 2)
+			{
+				convert_band(0, height);
+				return;
+			}
+
+			// Each band starts on a multiple of 4 rows, the row bases are recomputed independently so bands can be processed in any order
+			atomic_t<u32> next_band = 0;
+
+			const named_thread_group workers("Swizzle Worker "sv, thread_count, [&]()
+			{
+				for (u32 band = next_band++; band < band_count; band = next_band++)
+				{
+					const u32 y_begin = band * rows_per_band;
+					convert_band(y_begin, std::min<u32>(y_begin + rows_per_band, height));
+				}
+			});
+		}
+
+		template <typename T>
+		static void convert_linear_swizzle_3d(const void* input_pixels, void* output_pixels, u16 width, u16 height, u16 depth)
+		{
+			if (depth == 1)
+			{
+				convert_linear_swizzle<T, true>(input_pixels, output_pixels, width, height, width * sizeof(T));
+				return;
+			}
+
+			auto src = static_cast<const T*>(input_pixels);
+			auto dst = static_cast<T*>(output_pixels);
+
+			const u32 log2_w = ceil_log2(width);
+			const u32 log2_h = ceil_log2(height);
+			const u32 log2_d = ceil_log2(depth);
+
+			// The bit positions of each axis only depend on the dimensions, so the z-index is the OR of the per-axis contributions
+			std::vector<u32> x_offsets(width), y_offsets(height);
+
+			for (u32 x = 0; x < width; ++x)
+			{
+				x_offsets[x] = calculate_z_index(x, 0, 0, log2_w, log2_h, log2_d);
+			}
+
+			for (u32 y = 0; y < height; ++y)
+			{
+				y_offsets[y] = calculate_z_index(0, y, 0, log2_w, log2_h, log2_d);
+			}
+
+			for (u32 z = 0; z < depth; ++z)
+			{
+				const u32 offs_z = calculate_z_index(0, 0, z, log2_w, log2_h, log2_d);
+
+				for (u32 y = 0; y < height; ++y)
+				{
+					const u32 offs_yz = offs_z | y_offsets[y];
+
+					for (u32 x = 0; x < width; ++x)
+					{
+						*dst++ = src[offs_yz | x_offsets[x]];
+					}
+				}
+			}
+		}
+	}
+
+	void convert_linear_swizzle_impl(const void* input_pixels, void* output_pixels, u16 width, u16 height, u32 pitch, u32 texel_size, bool input_is_swizzled)
+	{
+		auto convert = [&]<typename T>()
+		{
+			if (input_is_swizzled)
+			{
+				swizzle::convert_linear_swizzle<T, true>(input_pixels, output_pixels, width, height, pitch);
+			}
+			else
+			{
+				swizzle::convert_linear_swizzle<T, false>(input_pixels, output_pixels, width, height, pitch);
+			}
+		};
+
+		switch (texel_size)
+		{
+		case 1: convert.template operator()<u8>(); break;
+		case 2: convert.template operator()<u16>(); break;
+		case 4: convert.template operator()<u32>(); break;
+		case 8: convert.template operator()<u64>(); break;
+		case 16: convert.template operator()<swizzle::texel_t<16>>(); break;
+		default: fmt::throw_exception("Unsupported texel size %u", texel_size);
+		}
+	}
+
+	void convert_linear_swizzle_3d_impl(const void* input_pixels, void* output_pixels, u16 width, u16 height, u16 depth, u32 texel_size)
+	{
+		switch (texel_size)
+		{
+		case 1: swizzle::convert_linear_swizzle_3d<u8>(input_pixels, output_pixels, width, height, depth); break;
+		case 2: swizzle::convert_linear_swizzle_3d<u16>(input_pixels, output_pixels, width, height, depth); break;
+		case 4: swizzle::convert_linear_swizzle_3d<u32>(input_pixels, output_pixels, width, height, depth); break;
+		case 8: swizzle::convert_linear_swizzle_3d<u64>(input_pixels, output_pixels, width, height, depth); break;
+		case 16: swizzle::convert_linear_swizzle_3d<swizzle::texel_t<16>>(input_pixels, output_pixels, width, height, depth); break;
+		default: fmt::throw_exception("Unsupported texel size %u", texel_size);
+		}
+	}
+
 	void convert_scale_image(u8 *dst, AVPixelFormat dst_format, int dst_width, int dst_height, int dst_pitch,
 		const u8 *src, AVPixelFormat src_format, int src_width, int src_height, int src_pitch, int src_slice_h, bool bilinear)
 	{
@@ -102,6 +393,8 @@ namespace rsx
 		}
 	}
 
+	page_lock_table_t page_lock_table = {};
+
 #ifdef TEXTURE_CACHE_DEBUG
 	tex_cache_checker_t tex_cache_checker = {};
 #endif
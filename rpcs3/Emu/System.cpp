@@ -2,6 +2,7 @@
 #include "VFS.h"
 #include "Utilities/bin_patch.h"
 #include "Emu/Memory/vm.h"
+#include "Emu/Memory/vm_reservation.h"
 #include "Emu/System.h"
 #include "Emu/system_progress.hpp"
 #include "Emu/system_utils.hpp"
@@ -11,6 +12,7 @@
 #include "Emu/Cell/PPUThread.h"
 #include "Emu/Cell/PPUDisAsm.h"
 #include "Emu/Cell/PPUAnalyser.h"
+#include "Emu/Cell/PPUProfiler.h"
 #include "Emu/Cell/SPUThread.h"
 #include "Emu/RSX/RSXThread.h"
 #include "Emu/Cell/lv2/sys_process.h"
@@ -220,6 +222,10 @@ void init_fxo_for_exec(utils::serial* ar, bool full = false)
 	fxo_serialize<music_state>(ar);
 
 	g_fxo->init(false, ar);
+
+	// Guest PPU sampling profiler (idle unless enabled)
+	g_fxo->need<named_thread<ppu_profiler>>();
+
 	Emu.GetCallbacks().init_gs_render(ar);
 	Emu.GetCallbacks().init_pad_handler(Emu.GetTitleID());
 	Emu.GetCallbacks().init_kb_handler();
@@ -1780,6 +1786,7 @@ void Emulator::Resume()
 	}
 
 	perf_stat_base::report();
+	vm::reservation_report_stats(false);
 
 	// Try to resume
 	if (!m_state.compare_and_swap_test(system_state::paused, system_state::running))
@@ -1974,6 +1981,7 @@ void Emulator::Stop(bool savestate, bool restart)
 	jit_runtime::finalize();
 
 	perf_stat_base::report();
+	vm::reservation_report_stats(true);
 
 	static u64 aw_refs = 0;
 	static u64 aw_colm = 0;
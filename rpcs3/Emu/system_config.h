@@ -22,18 +22,22 @@ struct cfg_root : cfg::node
 		cfg::_enum<ppu_decoder_type> ppu_decoder{ this, "PPU Decoder", ppu_decoder_type::llvm };
 		cfg::_int<1, 8> ppu_threads{ this, "PPU Threads", 2 }; // Amount of PPU threads running simultaneously (must be 2)
 		cfg::_bool ppu_debug{ this, "PPU Debug" };
+		cfg::_int<0, 1000> ppu_profiler_frequency{ this, "PPU Profiler Sampling Frequency", 0 }; // Samples per second, 0 disables the profiler
 		cfg::_bool llvm_logs{ this, "Save LLVM logs" };
 		cfg::string llvm_cpu{ this, "Use LLVM CPU" };
 		cfg::_int<0, 1024> llvm_threads{ this, "Max LLVM Compile Threads", 0 };
 		cfg::_bool ppu_llvm_greedy_mode{ this, "PPU LLVM Greedy Mode", false, false };
 		cfg::_bool ppu_llvm_precompilation{ this, "PPU LLVM Precompilation", true };
+		cfg::_bool ppu_llvm_tiered{ this, "PPU LLVM Tiered Compilation", false }; // Run new code compiled with fewer optimizations until it is recompiled in the background
 		cfg::_enum<thread_scheduler_mode> thread_scheduler{this, "Thread Scheduler Mode", thread_scheduler_mode::os};
 		cfg::_bool set_daz_and_ftz{ this, "Set DAZ and FTZ", false };
 		cfg::_enum<spu_decoder_type> spu_decoder{ this, "SPU Decoder", spu_decoder_type::llvm };
+		cfg::_bool spu_llvm_asmjit_tier{ this, "SPU LLVM ASMJIT Tier", false }; // Run new programs with ASMJIT until SPU LLVM replaces them
 		cfg::_bool lower_spu_priority{ this, "Lower SPU thread priority" };
 		cfg::_bool spu_getllar_polling_detection{ this, "SPU GETLLAR polling detection", false, true };
 		cfg::_bool spu_debug{ this, "SPU Debug" };
 		cfg::_bool mfc_debug{ this, "MFC Debug" };
+		cfg::_enum<jit_profiler_output> jit_profiler{ this, "JIT Symbols For Host Profiler", jit_profiler_output::disabled }; // Linux perf symbols for PPU/SPU code
 		cfg::_int<0, 6> preferred_spu_threads{ this, "Preferred SPU Threads", 0, true }; // Number of hardware threads dedicated to heavy simultaneous spu tasks
 		cfg::_int<0, 16> spu_delay_penalty{ this, "SPU delay penalty", 3 }; // Number of milliseconds to block a thread if a virtual 'core' isn't free
 		cfg::_bool spu_loop_detection{ this, "SPU loop detection", true, true }; // Try to detect wait loops and trigger thread yield
@@ -143,6 +147,10 @@ struct cfg_root : cfg::node
 		cfg::_bool strict_rendering_mode{ this, "Strict Rendering Mode" };
 		cfg::_bool disable_zcull_queries{ this, "Disable ZCull Occlusion Queries", false, true };
 		cfg::_bool disable_vertex_cache{ this, "Disable Vertex Cache", false };
+		cfg::_bool strict_vertex_cache{ this, "Strict Vertex Cache", false };
+		cfg::_bool index_buffer_cache{ this, "Index Buffer Cache", false };
+		cfg::_enum<stats_log_format> texture_cache_stats_log{ this, "Texture Cache Statistics Log", stats_log_format::disabled, true };
+		cfg::_enum<method_profiling_mode> method_profiling{ this, "RSX Method Profiling", method_profiling_mode::disabled };
 		cfg::_bool disable_FIFO_reordering{ this, "Disable FIFO Reordering", false };
 		cfg::_bool frame_skip_enabled{ this, "Enable Frame Skip", false, true };
 		cfg::_bool force_cpu_blit_processing{ this, "Force CPU Blit", false, true }; // Debugging option
@@ -162,6 +170,7 @@ struct cfg_root : cfg::node
 		cfg::_int<-16, 16> texture_lod_bias{ this, "Texture LOD Bias Addend", 0, true };
 		cfg::_int<1, 1024> min_scalable_dimension{ this, "Minimum Scalable Dimension", 16 };
 		cfg::_int<0, 16> shader_compiler_threads_count{ this, "Shader Compiler Threads", 0 };
+		cfg::_int<0, 8> offload_threads_count{ this, "RSX Offload Threads", 0 }; // Only used with Multithreaded RSX
 		cfg::_int<0, 30000000> driver_recovery_timeout{ this, "Driver Recovery Timeout", 1000000, true };
 		cfg::_int<0, 16667> driver_wakeup_delay{ this, "Driver Wake-Up Delay", 1, true };
 		cfg::_int<1, 1800> vblank_rate{ this, "Vblank Rate", 60, true }; // Changing this from 60 may affect game speed in unexpected ways
@@ -192,6 +201,7 @@ struct cfg_root : cfg::node
 			cfg::_enum<detail_level> level{ this, "Detail level", detail_level::medium, true };
 			cfg::_enum<perf_graph_detail_level> framerate_graph_detail_level{ this, "Framerate graph detail level", perf_graph_detail_level::show_all, true };
 			cfg::_enum<perf_graph_detail_level> frametime_graph_detail_level{ this, "Frametime graph detail level", perf_graph_detail_level::show_all, true };
+			cfg::_bool texture_cache_stats{ this, "Show Texture Cache Statistics", false, true };
 			cfg::uint<1, 1000> update_interval{ this, "Metrics update interval (ms)", 350, true };
 			cfg::uint<4, 36> font_size{ this, "Font size (px)", 10, true };
 			cfg::_enum<screen_quadrant> position{ this, "Position", screen_quadrant::top_left, true };
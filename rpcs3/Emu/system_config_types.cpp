@@ -469,3 +469,51 @@ void fmt_class_string<thread_scheduler_mode>::format(std::string& out, u64 arg)
 		return unknown;
 	});
 }
+
+template <>
+void fmt_class_string<stats_log_format>::format(std::string& out, u64 arg)
+{
+	format_enum(out, arg, [](stats_log_format value)
+	{
+		switch (value)
+		{
+		case stats_log_format::disabled: return "Disabled";
+		case stats_log_format::csv: return "CSV";
+		case stats_log_format::json: return "JSON";
+		}
+
+		return unknown;
+	});
+}
+
+template <>
+void fmt_class_string<method_profiling_mode>::format(std::string& out, u64 arg)
+{
+	format_enum(out, arg, [](method_profiling_mode value)
+	{
+		switch (value)
+		{
+		case method_profiling_mode::disabled: return "Disabled";
+		case method_profiling_mode::statistics: return "Statistics";
+		case method_profiling_mode::trace: return "Statistics and Trace";
+		}
+
+		return unknown;
+	});
+}
+
+template <>
+void fmt_class_string<jit_profiler_output>::format(std::string& out, u64 arg)
+{
+	format_enum(out, arg, [](jit_profiler_output value)
+	{
+		switch (value)
+		{
+		case jit_profiler_output::disabled: return "Disabled";
+		case jit_profiler_output::perf_map: return "Perf Map";
+		case jit_profiler_output::jitdump: return "Jitdump";
+		}
+
+		return unknown;
+	});
+}
@@ -216,3 +216,24 @@ enum class perf_graph_detail_level
 	show_one_percent_avg,
 	show_all
 };
+
+enum class stats_log_format
+{
+	disabled,
+	csv,
+	json
+};
+
+enum class method_profiling_mode
+{
+	disabled,
+	statistics,
+	trace, // Statistics and a trace of every method call
+};
+
+enum class jit_profiler_output
+{
+	disabled,
+	perf_map, // /tmp/perf-<pid>.map
+	jitdump, // /tmp/jit-<pid>.dump, to be merged with perf inject --jit
+};
@@ -70,6 +70,12 @@ bool utils::has_avx2()
 	return g_value;
 }
 
+bool utils::has_bmi2()
+{
+	static const bool g_value = get_cpuid(0, 0)[0] >= 0x7 && (get_cpuid(7, 0)[1] & 0x100) == 0x100;
+	return g_value;
+}
+
 bool utils::has_rtm()
 {
 	static const bool g_value = get_cpuid(0, 0)[0] >= 0x7 && (get_cpuid(7, 0)[1] & 0x800) == 0x800;
@@ -17,6 +17,8 @@ namespace utils
 
 	bool has_avx2();
 
+	bool has_bmi2();
+
 	bool has_rtm();
 
 	bool has_tsx_force_abort();